@@ -4,10 +4,45 @@
 #include <gtkmm/label.h>
 #include <json/json.h>
 
+#include <optional>
+#include <unordered_map>
+
+#include "util/format_template.hpp"
+
 #include "AModule.hpp"
 
 namespace waybar {
 
+/**
+ * Gtk::Label that remembers a hash of the last applied text, markup and tooltip.
+ *
+ * Setting a label re-runs Pango layout and size negotiation for the whole bar box, even when
+ * the string did not change. Updates that render the same content are skipped and counted in
+ * the module stats given to setStats().
+ */
+class Label : public Gtk::Label {
+ public:
+  void set_text(const Glib::ustring &text);
+  void set_markup(const Glib::ustring &markup);
+  void set_tooltip_text(const Glib::ustring &text);
+  void set_tooltip_markup(const Glib::ustring &markup);
+  void set_has_tooltip(bool has_tooltip);
+  // Add or remove a CSS class, only touching the style context on a transition
+  void add_class(const Glib::ustring &name);
+  void remove_class(const Glib::ustring &name);
+
+  void setStats(std::shared_ptr<util::ModuleStats> stats) { stats_ = std::move(stats); }
+
+ private:
+  // Returns true (and records `hash`) if `hash` differs from `last`
+  bool changed(std::optional<size_t> &last, size_t hash);
+  void countChange(bool applied);
+
+  std::optional<size_t> label_hash_;
+  std::optional<size_t> tooltip_hash_;
+  std::shared_ptr<util::ModuleStats> stats_;
+};
+
 class ALabel : public AModule {
  public:
   ALabel(const Json::Value &, const std::string &, const std::string &, const std::string &format,
@@ -15,11 +50,12 @@ class ALabel : public AModule {
          bool enable_scroll = false);
   virtual ~ALabel() = default;
   auto update() -> void override;
+  Json::Value state() const override;
   virtual std::string getIcon(uint16_t, const std::string &alt = "", uint16_t max = 0);
   virtual std::string getIcon(uint16_t, const std::vector<std::string> &alts, uint16_t max = 0);
 
  protected:
-  Gtk::Label label_;
+  Label label_;
   std::string format_;
   const std::chrono::milliseconds interval_;
   bool alt_ = false;
@@ -28,6 +64,22 @@ class ALabel : public AModule {
   bool handleToggle(GdkEventButton *const &e) override;
   virtual std::string getState(uint8_t value, bool lesser = false);
 
+  // Template of `format`, compiled with `bind` on first use and kept for the module's lifetime
+  const util::FormatTemplate &formatTemplate(const std::string &format,
+                                             const util::FormatTemplate::Binder &bind = nullptr);
+  // Render buffer reused across updates
+  std::string markup_;
+
+  std::unordered_map<std::string, util::FormatTemplate> format_templates_;
+  // "states" of the config, highest threshold first
+  std::vector<std::pair<std::string, uint8_t>> states_;
+  // State class currently applied to the label
+  std::string state_class_;
+  // "format-icons" of the config, per alternative and for the default
+  std::unordered_map<std::string, std::vector<std::string>> icons_;
+  std::vector<std::string> default_icons_;
+  static const std::string &pickIcon(const std::vector<std::string> &icons, uint16_t percentage,
+                                     uint16_t max);
   std::map<std::string, GtkMenuItem *> submenus_;
   std::map<std::string, std::string> menuActionsMap_;
   static void handleGtkMenuEvent(GtkMenuItem *menuitem, gpointer data);
@@ -1,12 +1,13 @@
 #pragma once
 
-#include <glibmm/dispatcher.h>
 #include <glibmm/markup.h>
 #include <gtkmm.h>
 #include <gtkmm/eventbox.h>
 #include <json/json.h>
 
 #include "IModule.hpp"
+#include "util/dispatcher.hpp"
+#include "util/telemetry.hpp"
 
 namespace waybar {
 
@@ -19,9 +20,18 @@ class AModule : public IModule {
   virtual auto refresh(int shouldRefresh) -> void {};
   operator Gtk::Widget &() override;
   auto doAction(const std::string &name) -> void override;
+  // Run the module action and the command configured for `event`, e.g. "on-click", as if the
+  // user had done it
+  virtual void triggerEvent(const std::string &event);
+  // True for the click and scroll events of the config, "on-click-right" but not "exec"
+  static bool isUserEvent(const std::string &event);
+  // What the module shows, answered to "get" on the control socket
+  virtual Json::Value state() const;
 
   /// Emitting on this dispatcher triggers a update() call
-  Glib::Dispatcher dp;
+  util::Dispatcher dp;
+  // Cost of this module, see util::Telemetry
+  const std::shared_ptr<util::ModuleStats> &stats() const { return stats_; }
 
   bool expandEnabled() const;
 
@@ -55,6 +65,7 @@ class AModule : public IModule {
   const bool isTooltip;
   const bool isExpand;
   bool hasUserEvents_;
+  const std::shared_ptr<util::ModuleStats> stats_;
   gdouble distance_scrolled_y_;
   gdouble distance_scrolled_x_;
   std::map<std::string, std::string> eventActionMap_;
@@ -72,6 +72,8 @@ class Bar : public sigc::trackable {
   void show();
   void hide();
   void handleSignal(int);
+  // Modules created from `ref`, e.g. "custom/vpn", or every module if empty. Groups included.
+  std::vector<std::shared_ptr<waybar::AModule>> findModules(const std::string &ref) const;
   util::KillSignalAction getOnSigusr1Action();
   util::KillSignalAction getOnSigusr2Action();
 
@@ -5,8 +5,11 @@
 #include <gdk/gdkwayland.h>
 #include <wayland-client.h>
 
+#include <set>
+
 #include "bar.hpp"
 #include "config.hpp"
+#include "util/control_socket.hpp"
 #include "util/css_reload_helper.hpp"
 #include "util/portal.hpp"
 
@@ -30,6 +33,10 @@ class Client {
   std::vector<std::unique_ptr<Bar>> bars;
   Config config;
   std::string bar_id;
+  // Where SIGRTMIN writes the module stats, see util::Telemetry
+  std::string stats_path;
+  // Path of the control socket, "none" to not open one
+  std::string socket_path;
 
  private:
   Client() = default;
@@ -49,6 +56,8 @@ class Client {
   void handleMonitorAdded(Glib::RefPtr<Gdk::Monitor> monitor);
   void handleMonitorRemoved(Glib::RefPtr<Gdk::Monitor> monitor);
   void handleDeferredMonitorRemoval(Glib::RefPtr<Gdk::Monitor> monitor);
+  void setupControlSocket();
+  std::string handleRequest(const util::ControlSocket::Request &request);
 
   Glib::RefPtr<Gtk::StyleContext> style_context_;
   Glib::RefPtr<Gtk::CssProvider> css_provider_;
@@ -56,6 +65,9 @@ class Client {
   std::list<struct waybar_output> outputs_;
   std::unique_ptr<CssReloadHelper> m_cssReloadHelper;
   std::string m_cssFile;
+  std::unique_ptr<util::ControlSocket> control_socket_;
+  // Modules pushed to by the requests being handled, updated once they all were
+  std::set<std::shared_ptr<AModule>> pushed_;
 };
 
 }  // namespace waybar
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <gtkmm/window.h>
+
 #include <atomic>
 #include <chrono>
 #include <mutex>
@@ -14,10 +16,25 @@ namespace waybar::modules {
 
 class Autohide : public AModule, public waybar::modules::hyprland::EventHandler {
  public:
-  Autohide(const std::string& id, Bar& bar, const Json::Value& config);
+  Autohide(const std::string& id, const Bar& bar, const Json::Value& config);
   ~Autohide();
 
  private:
+  // State machine - only one state can be true at any time
+  enum class WaybarState {
+    VISIBLE,          // Waybar is currently visible
+    HIDDEN,           // Waybar is currently hidden
+    PENDING_VISIBLE,  // Waybar is hidden but show timer is running
+    PENDING_HIDDEN    // Waybar is visible but hide timer is running
+  };
+
+  void setupHotZone();
+  void fallBackToPolling();
+  void setHotZoneInput(bool enabled);
+  bool handleHotZoneCrossing(GdkEventCrossing* ev);
+  bool handleBarCrossing(GdkEventCrossing* ev);
+  void onPointerCrossed();
+  void schedule(WaybarState pending, uint32_t delay);
   void startMouseTracking();
   void stopMouseTracking();
   void mouseTrackingThread();
@@ -38,18 +55,27 @@ class Autohide : public AModule, public waybar::modules::hyprland::EventHandler
   uint32_t check_interval_;
   uint32_t consecutive_checks_before_visible_;
 
-  // State machine - only one state can be true at any time
-  enum class WaybarState {
-    VISIBLE,          // Waybar is currently visible
-    HIDDEN,           // Waybar is currently hidden
-    PENDING_VISIBLE,  // Waybar is hidden but show timer is running
-    PENDING_HIDDEN    // Waybar is visible but hide timer is running
-  };
+  bool use_hot_zone_;
 
   std::atomic<WaybarState> waybar_state_;
   std::chrono::steady_clock::time_point timer_start_;
 
-  // Threading
+  // Hot zone: a transparent layer surface along the bar's edge. Pointer crossings of it and of
+  // the bar drive the state machine, with the pending transitions timed on the main loop.
+  Gtk::Window hot_zone_;
+  // The zone only takes input while the bar is hidden, so that it doesn't cover the bar's edge or
+  // what is below it otherwise
+  bool hot_zone_input_{true};
+  // Set by the compositor's first configure of the zone
+  bool hot_zone_configured_{false};
+  bool pointer_in_hot_zone_{false};
+  bool pointer_in_bar_{false};
+  sigc::connection pending_timer_;
+  sigc::connection map_check_;
+  sigc::connection bar_enter_;
+  sigc::connection bar_leave_;
+
+  // Threading, only used when polling the cursor position
   std::thread mouse_thread_;
   std::atomic<bool> mouse_thread_running_;
   std::atomic<bool> mouse_thread_exit_;
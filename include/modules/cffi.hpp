@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <vector>
 
-#include "AModule.hpp"
+#include "ALabel.hpp"
 #include "util/command.hpp"
 #include "util/json.hpp"
 #include "util/sleeper_thread.hpp"
@@ -13,11 +15,22 @@ namespace ffi {
 extern "C" {
 typedef struct wbcffi_module wbcffi_module;
 
+typedef struct {
+  const char* text;
+  const char* alt;
+  const char* tooltip;
+  const char* const* classes;
+  size_t classes_len;
+  int percentage;
+} wbcffi_record;
+
 typedef struct {
   wbcffi_module* obj;
   const char* waybar_version;
   GtkContainer* (*get_root_widget)(wbcffi_module*);
   void (*queue_update)(wbcffi_module*);
+  // Since ABI version 3
+  void (*publish)(wbcffi_module*, const wbcffi_record*);
 } wbcffi_init_info;
 
 struct wbcffi_config_entry {
@@ -27,7 +40,14 @@ struct wbcffi_config_entry {
 }
 }  // namespace ffi
 
-class CFFI : public AModule {
+/**
+ * Module implemented by a dynamic library.
+ *
+ * Up to ABI version 2 the library builds its own widgets in the event box. From version 3 it
+ * may instead publish records, from any thread, that are shown by the label like the output of
+ * a custom module: "format", "format-icons", "states" and "tooltip-format" apply.
+ */
+class CFFI : public ALabel {
  public:
   CFFI(const std::string&, const std::string&, const Json::Value&);
   virtual ~CFFI();
@@ -37,8 +57,28 @@ class CFFI : public AModule {
   virtual auto update() -> void override;
 
  private:
+  // Copy of a wbcffi_record
+  struct Record {
+    std::string text;
+    std::string alt;
+    std::string tooltip;
+    std::vector<std::string> classes;
+    int percentage = 0;
+  };
+
+  // Called by the library, from any thread: hand `record` over to the next update
+  void publish(const ffi::wbcffi_record& record);
+  // Show record_ with the label
+  void render();
+
   ///
   void* cffi_instance_ = nullptr;
+  // Published record not shown yet, swapped without a lock between the library and update()
+  std::atomic<Record*> pending_ = nullptr;
+  // Latest record taken from pending_
+  Record record_;
+  // Whether the library builds its widgets instead of publishing records
+  bool widgets_ = true;
 
   typedef void*(InitFn)(const ffi::wbcffi_init_info* init_info,
                         const ffi::wbcffi_config_entry* config_entries, size_t config_entries_len);
@@ -2,7 +2,7 @@
 
 #include "ALabel.hpp"
 #include "util/date.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -64,7 +64,7 @@ class Clock final : public ALabel {
   int tzCurrIdx_;                               // current time zone index for tzList_
   std::string tzText_{""};                      // time zones text to print
   std::string tzTooltipFormat_{""};             // optional timezone tooltip format
-  util::SleeperThread thread_;
+  util::Scheduler::Subscription timer_;
 
   // ordinal date in tooltip
   const bool ordInTooltip_;
@@ -6,24 +6,38 @@
 #include <fstream>
 #include <numeric>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "modules/cpu_frequency.hpp"
+#include "modules/cpu_usage.hpp"
+#include "util/provider.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
 class Cpu : public ALabel {
  public:
   Cpu(const std::string&, const Json::Value&);
-  virtual ~Cpu() = default;
+  virtual ~Cpu();
   auto update() -> void override;
 
- private:
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
+  // Format slots on top of the ones of cpu_usage
+  enum Slot { LOAD = CpuUsage::SLOT_COUNT, MAX_FREQUENCY, MIN_FREQUENCY, AVG_FREQUENCY };
+  static int bindField(std::string_view name, size_t& index);
 
-  util::SleeperThread thread_;
+ private:
+  // Load and usage come from the system sampler, the frequency is shared with cpu_frequency
+  util::SystemSampler::Subscription sampler_;
+  std::shared_ptr<util::SampledProvider<CpuFrequency::Sample>> frequency_provider_;
+
+  // Snapshots the current usage and frequency were rendered from
+  std::shared_ptr<const util::SystemSampler::Snapshot> prev_;
+  std::shared_ptr<const CpuFrequency::Sample> frequency_;
+  CpuUsage::Sample usage_;
+  std::string rendered_format_;
 };
 
 }  // namespace waybar::modules
@@ -10,23 +10,25 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/provider.hpp"
 
 namespace waybar::modules {
 
 class CpuFrequency : public ALabel {
  public:
   CpuFrequency(const std::string&, const Json::Value&);
-  virtual ~CpuFrequency() = default;
+  virtual ~CpuFrequency();
   auto update() -> void override;
 
+  using Sample = std::tuple<float, float, float>;
+
   // This is a static member because it is also used by the cpu module.
-  static std::tuple<float, float, float> getCpuFrequency();
+  static Sample getCpuFrequency();
 
  private:
   static std::vector<float> parseCpuFrequencies();
 
-  util::SleeperThread thread_;
+  std::shared_ptr<util::SampledProvider<Sample>> provider_;
 };
 
 }  // namespace waybar::modules
@@ -6,30 +6,39 @@
 #include <fstream>
 #include <numeric>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/proc_stat.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
 class CpuUsage : public ALabel {
  public:
   CpuUsage(const std::string&, const Json::Value&);
-  virtual ~CpuUsage() = default;
+  virtual ~CpuUsage();
   auto update() -> void override;
 
-  // This is a static member because it is also used by the cpu module.
-  static std::tuple<std::vector<uint16_t>, std::string> getCpuUsage(
-      std::vector<std::tuple<size_t, size_t>>&);
+  using Sample = std::tuple<std::vector<uint16_t>, std::string>;
 
- private:
-  static std::vector<std::tuple<size_t, size_t>> parseCpuinfo();
+  // These are static members because they are also used by the cpu module.
+  // An empty `prev_times` gives the average usage since boot.
+  static Sample getCpuUsage(const util::CpuTimes& prev_times, const util::CpuTimes& curr_times);
+  static void parseCpuinfo(util::CpuTimes&);
 
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
+  // Format slots, also used by the cpu module. usage<N> and icon<N> bind the core number N.
+  enum Slot { USAGE, ICON, CORE_USAGE, CORE_ICON, SLOT_COUNT };
+  static int bindField(std::string_view name, size_t& index);
 
-  util::SleeperThread thread_;
+ private:
+  util::SystemSampler::Subscription sampler_;
+  // Snapshot the current usage was computed from
+  std::shared_ptr<const util::SystemSampler::Snapshot> prev_;
+  Sample usage_;
+  std::string rendered_format_;
 };
 
 }  // namespace waybar::modules
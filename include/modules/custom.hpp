@@ -3,28 +3,76 @@
 #include <fmt/format.h>
 
 #include <csignal>
+#include <mutex>
+#include <optional>
 #include <string>
 
 #include "ALabel.hpp"
 #include "util/command.hpp"
 #include "util/json.hpp"
+#ifdef HAVE_PROCESS_REACTOR
+#include "util/process_reactor.hpp"
+#endif
+#include "util/provider.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
 
 namespace waybar::modules {
 
+/**
+ * Runs the commands of a "shared" custom module once for every bar that shows it.
+ */
+class CustomProvider : public util::Provider {
+ public:
+  CustomProvider(const Json::Value& config, std::chrono::milliseconds interval);
+  util::command::res output() const;
+  void wakeUp() { thread_.wake_up(); }
+
+ private:
+  const Json::Value config_;
+  mutable std::mutex output_mutex_;
+  util::command::res output_;
+
+  util::SleeperThread thread_;
+  util::Scheduler::Subscription timer_;
+};
+
 class Custom : public ALabel {
  public:
   Custom(const std::string&, const std::string&, const Json::Value&, const std::string&);
   virtual ~Custom();
   auto update() -> void override;
   void refresh(int /*signal*/) override;
+  void triggerEvent(const std::string& event) override;
+  Json::Value state() const override;
+  // Show `record`, a line in the format of "return-type", as if the script had printed it. The
+  // lines of a raw record are separated by "\n". Takes effect on the next update, false for
+  // shared modules whose output comes from elsewhere.
+  bool push(std::string record);
 
  private:
+  // Output of the script, parsed by parseOutputRaw or parseOutputJson
+  struct Record {
+    std::string text;
+    std::string alt;
+    std::string tooltip;
+    std::vector<std::string> classes;
+    int percentage = 0;
+  };
+
   void delayWorker();
   void continuousWorker();
+  void coprocessWorker();
+  void fileWorker();
   void waitingWorker();
-  void parseOutputRaw();
-  void parseOutputJson();
+  void sharedWorker(std::chrono::milliseconds interval);
+  void parseOutputRaw(const std::string& out, Record& record) const;
+  void parseOutputJson(const std::string& out, Record& record);
+  Record parseOutput(const std::string& out);
+  // Show `output` of a continuous script, coalesced with the next ones if configured
+  void publish(util::command::res output);
+  // Apply the latest coalesced output, false if there is none or it is not time to show it yet
+  bool takePending();
   void handleEvent();
   bool handleScroll(GdkEventScroll* e) override;
   bool handleToggle(GdkEventButton* const& e) override;
@@ -37,13 +85,35 @@ class Custom : public ALabel {
   std::string tooltip_;
   const bool tooltip_format_enabled_;
   std::vector<std::string> class_;
+  // class_ as last applied to the label
+  std::vector<std::string> label_class_;
   int percentage_;
   FILE* fp_;
   int pid_;
+  // Where coprocess requests are written, see coprocessWorker()
+  int coprocess_in_;
   util::command::res output_;
   util::JsonParser parser_;
 
+  // With "coalesce", lines of a continuous script are parsed off the main loop and only the
+  // latest one is shown
+  bool coalesce_;
+  // Minimum time between two coalesced updates, zero for one per main loop iteration
+  const std::chrono::milliseconds coalesce_period_;
+  std::mutex pending_mutex_;
+  std::optional<std::pair<util::command::res, Record>> pending_;
+  // Record pushed without "coalesce", applied by update()
+  std::optional<util::command::res> pushed_;
+  std::chrono::steady_clock::time_point next_apply_;
+  sigc::connection deferred_apply_;
+  std::shared_ptr<CustomProvider> provider_;
+
   util::SleeperThread thread_;
+  util::Scheduler::Subscription timer_;
+#ifdef HAVE_PROCESS_REACTOR
+  // Output of a continuous script or content of the watched file, read by the reactor thread
+  util::ProcessReactor::Watch reactor_watch_;
+#endif
 };
 
 }  // namespace waybar::modules
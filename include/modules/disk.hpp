@@ -7,7 +7,7 @@
 
 #include "ALabel.hpp"
 #include "util/format.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
@@ -18,7 +18,9 @@ class Disk : public ALabel {
   auto update() -> void override;
 
  private:
-  util::SleeperThread thread_;
+  util::SystemSampler::Subscription sampler_;
+  uint64_t rendered_version_ = 0;
+  std::string rendered_format_;
   std::string path_;
   std::string unit_;
 
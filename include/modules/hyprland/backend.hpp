@@ -1,12 +1,19 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
-#include <list>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "modules/hyprland/state.hpp"
 #include "util/json.hpp"
 
 namespace waybar::modules::hyprland {
@@ -28,22 +35,61 @@ class IPC {
 
   static std::string getSocket1Reply(const std::string& rq);
   Json::Value getSocket1JsonReply(const std::string& rq);
+  /**
+   * Parsed reply to `rq`, shared with every module asking for it until the next socket2 event.
+   * Callers asking while the same query runs wait for its reply instead of sending another.
+   */
+  std::shared_ptr<const Json::Value> getSocket1JsonReplyShared(const std::string& rq);
+  // Parsed replies to `rqs`, in order, with the ones not shared yet sent as one [[BATCH]] request
+  std::vector<std::shared_ptr<const Json::Value>> getSocket1JsonReplies(
+      const std::vector<std::string>& rqs);
   static std::filesystem::path getSocketFolder(const char* instanceSig);
+  /**
+   * Hyprland's monitors, workspaces and clients as of the last socket2 event. It is read once and
+   * then updated from the events while the listener runs, and read on every call otherwise.
+   */
+  std::shared_ptr<const State> getState();
 
  protected:
   static std::filesystem::path socketFolder_;
 
+  // Replies are only shared while socket2 events tell when they become stale
+  void setQueryCacheEnabled(bool enabled);
+  // Drops the shared replies, Hyprland's state changed
+  void nextGeneration() { generation_++; }
+  // Replies of a [[BATCH]] request, one per request
+  static std::vector<std::string> splitBatchReply(std::string_view reply);
+
  private:
+  struct Query {
+    std::shared_ptr<const Json::Value> reply;
+    uint64_t generation = 0;
+    bool running = false;
+  };
+
   void socketListener();
   void parseIPC(const std::string&);
+  void updateState(const std::string& ev);
+  std::vector<std::shared_ptr<const Json::Value>> query(const std::vector<std::string>& rqs);
 
   std::thread ipcThread_;
   std::mutex callbackMutex_;
   util::JsonParser parser_;
-  std::list<std::pair<std::string, EventHandler*>> callbacks_;
-  int socketfd_;  // the hyprland socket file descriptor
+  // Handlers by event name, in the order they registered
+  std::unordered_map<std::string, std::vector<EventHandler*>> callbacks_;
+  std::atomic<uint64_t> generation_ = 0;
+  std::atomic<bool> queryCacheEnabled_ = false;
+  std::mutex queryMutex_;
+  std::condition_variable queryDone_;
+  std::map<std::string, Query> queries_;
+  std::mutex stateMutex_;
+  // Null until a module reads it, and after it drifted from the events. Updated in place when no
+  // reader holds it anymore, copied otherwise.
+  std::shared_ptr<State> state_;
+  int socketfd_ = -1;  // the hyprland socket file descriptor
+  int wakeFd_ = -1;    // eventfd stopping the listener
   pid_t socketOwnerPid_;
-  bool running_ = true;
+  std::atomic<bool> running_ = true;
 };
 
 inline bool modulesReady = false;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace waybar::modules::hyprland {
+
+/**
+ * Hyprland's monitors, workspaces and clients, as read from socket1 once and then kept up to date
+ * from socket2 events.
+ *
+ * Applying an event the state doesn't match, e.g. a title change of an unknown window, fails: the
+ * state drifted and is read again. Window addresses are kept without their "0x" prefix, as events
+ * carry them.
+ */
+class State {
+ public:
+  struct Monitor {
+    int id = 0;
+    std::string name;
+    int activeWorkspaceId = 0;
+    // 0 and empty when no special workspace is shown
+    int specialWorkspaceId = 0;
+    std::string specialWorkspaceName;
+    bool focused = false;
+  };
+
+  struct Workspace {
+    int id = 0;
+    std::string name;
+    std::string monitor;
+    int windows = 0;
+    bool hasFullscreen = false;
+  };
+
+  struct Client {
+    std::string address;
+    int workspaceId = 0;
+    std::string className;
+    std::string initialClass;
+    std::string title;
+    std::string initialTitle;
+    bool floating = false;
+    bool fullscreen = false;
+    bool mapped = true;
+    bool hidden = false;
+  };
+
+  // From the replies to j/monitors, j/workspaces and j/clients
+  static State fromJson(const Json::Value& monitors, const Json::Value& workspaces,
+                        const Json::Value& clients);
+
+  // Whether events named `name` change the state
+  static bool tracks(std::string_view name);
+
+  // Update from the socket2 event `ev`, false if the state drifted and has to be read again
+  bool apply(std::string_view ev);
+
+  const Monitor* focusedMonitor() const;
+  const Monitor* findMonitor(std::string_view name) const;
+  const Workspace* findWorkspace(int id) const;
+  const Workspace* findWorkspace(std::string_view name) const;
+  const Client* findClient(std::string_view address) const;
+
+  // Clients on workspace `id`, shaped as in j/clients
+  Json::Value clientsJson(int workspaceId) const;
+
+  std::vector<Monitor> monitors;
+  std::map<int, Workspace> workspaces;
+  std::unordered_map<std::string, Client> clients;
+  // Address of the focused window, empty if none is
+  std::string activeWindow;
+
+ private:
+  Monitor* monitor(std::string_view name);
+  Workspace* workspace(std::string_view name);
+  // Show workspace `id` on its monitor and focus that monitor
+  bool activate(int id);
+  // Recount the windows of workspace `id` from the clients
+  void refresh(int id);
+};
+
+}  // namespace waybar::modules::hyprland
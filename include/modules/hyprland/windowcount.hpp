@@ -23,7 +23,6 @@ class WindowCount : public waybar::AAppIconLabel, public EventHandler {
     int id;
     int windows;
     bool hasfullscreen;
-    static auto parse(const Json::Value& value) -> Workspace;
   };
 
   static auto getActiveWorkspace(const std::string&) -> Workspace;
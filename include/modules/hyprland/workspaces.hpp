@@ -68,6 +68,7 @@ class Workspaces : public AModule, public EventHandler {
  private:
   void onEvent(const std::string& e) override;
   void updateWindowCount();
+  void updateWindowCount(const State& state);
   void sortSpecialCentered();
   void sortWorkspaces();
   void createWorkspace(Json::Value const& workspace_data,
@@ -127,8 +128,8 @@ class Workspaces : public AModule, public EventHandler {
   void doUpdate();
   void removeWorkspacesToRemove();
   void createWorkspacesToCreate();
-  static std::vector<int> getVisibleWorkspaces();
-  void updateWorkspaceStates();
+  static std::vector<int> getVisibleWorkspaces(const State& state);
+  void updateWorkspaceStates(const State& state);
   bool updateWindowsToCreate();
 
   void extendOrphans(int workspaceId, Json::Value const& clientsJson);
@@ -1,19 +1,28 @@
 #pragma once
 
 #include <fmt/format.h>
+#include <gdkmm/pixbuf.h>
 #include <gtkmm/image.h>
 
+#include <atomic>
 #include <csignal>
+#include <mutex>
+#include <optional>
 #include <string>
 
 #include "ALabel.hpp"
 #include "gtkmm/box.h"
 #include "util/command.hpp"
 #include "util/json.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
 
 namespace waybar::modules {
 
+/**
+ * Shows an image file. Its path is run and the file decoded on a worker thread, the main loop
+ * only puts the result on screen, and only when the file, the size or the scale changed.
+ */
 class Image : public AModule {
  public:
   Image(const std::string&, const Json::Value&);
@@ -21,20 +30,45 @@ class Image : public AModule {
   auto update() -> void override;
   void refresh(int /*signal*/) override;
 
+  // What a decoded image depends on
+  struct Key {
+    std::string path;
+    int64_t mtime_ns = 0;
+    int size = 0;
+    int scale = 1;
+
+    bool operator==(const Key&) const = default;
+    auto operator<=>(const Key&) const = default;
+  };
+
  private:
+  // Decoded by the worker, shown by update()
+  struct Frame {
+    Key key;
+    // Null if there is no image to show
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    std::string tooltip;
+  };
+
   void delayWorker();
   void handleEvent();
-  void parseOutputRaw();
+  // Path and tooltip of the image, from "path" or the output of "exec"
+  std::pair<std::string, std::string> source();
 
   Gtk::Box box_;
   Gtk::Image image_;
-  std::string path_;
-  std::string tooltip_;
   int size_;
   std::chrono::milliseconds interval_;
-  util::command::res output_;
+  // Scale factor of the image, read by the worker
+  std::atomic<int> scale_ = 1;
+
+  std::mutex frame_mutex_;
+  std::optional<Frame> pending_;
+  // Key and tooltip of the last frame handed to update(), only used by the worker
+  std::optional<std::pair<Key, std::string>> published_;
 
   util::SleeperThread thread_;
+  util::Scheduler::Subscription timer_;
 };
 
 }  // namespace waybar::modules
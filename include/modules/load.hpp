@@ -2,6 +2,7 @@
 
 #include <fmt/format.h>
 
+#include <array>
 #include <cstdint>
 #include <fstream>
 #include <numeric>
@@ -10,21 +11,26 @@
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
 class Load : public ALabel {
  public:
   Load(const std::string&, const Json::Value&);
-  virtual ~Load() = default;
+  virtual ~Load();
   auto update() -> void override;
 
+  using Sample = std::tuple<double, double, double>;
+
   // This is a static member because it is also used by the cpu module.
-  static std::tuple<double, double, double> getLoad();
+  // Rounds the raw load average up to two decimals.
+  static Sample getLoad(const std::array<double, 3>& loadavg);
 
  private:
-  util::SleeperThread thread_;
+  util::SystemSampler::Subscription sampler_;
+  uint64_t rendered_version_ = 0;
+  std::string rendered_format_;
 };
 
 }  // namespace waybar::modules
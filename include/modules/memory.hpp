@@ -6,7 +6,7 @@
 #include <unordered_map>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
@@ -16,12 +16,13 @@ class Memory : public ALabel {
   virtual ~Memory() = default;
   auto update() -> void override;
 
- private:
-  void parseMeminfo();
-
-  std::unordered_map<std::string, unsigned long> meminfo_;
+  // Platform reader of the memory counters (in kB), run by the system sampler
+  static void parseMeminfo(util::SystemSampler::Meminfo&);
 
-  util::SleeperThread thread_;
+ private:
+  util::SystemSampler::Subscription sampler_;
+  uint64_t rendered_version_ = 0;
+  std::string rendered_format_;
 };
 
 }  // namespace waybar::modules
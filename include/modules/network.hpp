@@ -13,6 +13,7 @@
 
 #include "ALabel.hpp"
 #include "util/sleeper_thread.hpp"
+#include "util/system_sampler.hpp"
 #ifdef WANT_RFKILL
 #include "util/rfkill.hpp"
 #endif
@@ -50,7 +51,8 @@ class Network : public ALabel {
   auto getInfo() -> void;
   const std::string getNetworkState() const;
   void clearIface();
-  std::optional<std::pair<unsigned long long, unsigned long long>> readBandwidthUsage();
+  std::optional<std::pair<unsigned long long, unsigned long long>> readBandwidthUsage(
+      const util::SystemSampler::Snapshot&) const;
 
   int ifid_{-1};
   ip_addr_pref addr_pref_{ip_addr_pref::IPV4};
@@ -68,8 +70,14 @@ class Network : public ALabel {
   bool dump_in_progress_{false};
   bool is_p2p_{false};
 
+  util::SystemSampler::Subscription sampler_;
+  uint64_t bandwidth_version_{0};
+  std::chrono::steady_clock::time_point bandwidth_taken_;
   unsigned long long bandwidth_down_total_{0};
   unsigned long long bandwidth_up_total_{0};
+  // Octets per second between the last two snapshots
+  unsigned long long bandwidth_down_{0};
+  unsigned long long bandwidth_up_{0};
 
   std::string state_;
   std::string essid_;
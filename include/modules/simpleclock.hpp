@@ -3,7 +3,7 @@
 #include <fmt/chrono.h>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -14,7 +14,7 @@ class Clock : public ALabel {
   auto update() -> void override;
 
  private:
-  util::SleeperThread thread_;
+  util::Scheduler::Subscription timer_;
 };
 
 }  // namespace waybar::modules
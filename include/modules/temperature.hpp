@@ -5,7 +5,8 @@
 #include <fstream>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
+#include "util/system_sampler.hpp"
 
 namespace waybar::modules {
 
@@ -21,7 +22,11 @@ class Temperature : public ALabel {
   bool isWarning(uint16_t);
 
   std::string file_path_;
-  util::SleeperThread thread_;
+  // The input file is read by the system sampler, FreeBSD polls sysctl on its own timer
+  util::SystemSampler::Subscription sampler_;
+  util::Scheduler::Subscription timer_;
+  uint64_t rendered_version_ = 0;
+  std::string rendered_format_;
 };
 
 }  // namespace waybar::modules
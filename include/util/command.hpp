@@ -3,17 +3,15 @@
 #include <fcntl.h>
 #include <giomm.h>
 #include <spdlog/spdlog.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
-#ifdef __FreeBSD__
-#include <sys/procctl.h>
-#endif
-
 #include <array>
+#include <chrono>
+
+#include "util/spawn.hpp"
+#include "util/telemetry.hpp"
 
 extern std::mutex reap_mtx;
 extern std::list<pid_t> reap;
@@ -78,55 +76,82 @@ inline FILE* open(const std::string& cmd, int& pid, const std::string& output_na
     return nullptr;
   }
 
-  pid_t child_pid = fork();
+  // Kill the child if Waybar exits
+  SpawnOptions options;
+  options.stdout_fd = fd[1];
+  options.deathsig = SIGTERM;
+  options.output_name = output_name;
+  pid_t child_pid = spawn(cmd, options);
+  ::close(fd[1]);
 
   if (child_pid < 0) {
     spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
     ::close(fd[0]);
-    ::close(fd[1]);
     return nullptr;
   }
-
-  if (!child_pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in open failed: {}", strerror(err));
-    // Kill child if Waybar exits
-    int deathsig = SIGTERM;
-#ifdef __linux__
-    if (prctl(PR_SET_PDEATHSIG, deathsig) != 0) {
-      spdlog::error("prctl(PR_SET_PDEATHSIG) in open failed: {}", strerror(errno));
-    }
-#endif
-#ifdef __FreeBSD__
-    if (procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig)) == -1) {
-      spdlog::error("procctl(PROC_PDEATHSIG_CTL) in open failed: {}", strerror(errno));
-    }
-#endif
-    ::close(fd[0]);
-    dup2(fd[1], 1);
-    setpgid(child_pid, child_pid);
-    if (output_name != "") {
-      setenv("WAYBAR_OUTPUT_NAME", output_name.c_str(), 1);
-    }
-    execlp("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    ::close(fd[1]);
+  if (const auto& stats = Telemetry::current()) {
+    stats->forks++;
   }
   pid = child_pid;
   return fdopen(fd[0], "r");
 }
 
+/**
+ * Start `cmd` as a coprocess: like open(), and its stdin is connected to `in`.
+ * `in` is a socket, write to it with send(MSG_NOSIGNAL) so a dead child can't raise SIGPIPE.
+ */
+inline FILE* openCoprocess(const std::string& cmd, int& pid, int& in,
+                           const std::string& output_name) {
+  if (cmd == "") return nullptr;
+  int out[2];
+  int sv[2];
+  if (pipe2(out, O_CLOEXEC) != 0) {
+    spdlog::error("Unable to pipe fd");
+    return nullptr;
+  }
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+    spdlog::error("Unable to create socket pair");
+    ::close(out[0]);
+    ::close(out[1]);
+    return nullptr;
+  }
+  // Waybar only writes requests, the child only reads them
+  shutdown(sv[0], SHUT_RD);
+  shutdown(sv[1], SHUT_WR);
+
+  SpawnOptions options;
+  options.stdin_fd = sv[1];
+  options.stdout_fd = out[1];
+  options.deathsig = SIGTERM;
+  options.output_name = output_name;
+  pid_t child_pid = spawn(cmd, options);
+  ::close(sv[1]);
+  ::close(out[1]);
+
+  if (child_pid < 0) {
+    spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
+    ::close(sv[0]);
+    ::close(out[0]);
+    return nullptr;
+  }
+  if (const auto& stats = Telemetry::current()) {
+    stats->forks++;
+  }
+  pid = child_pid;
+  in = sv[0];
+  return fdopen(out[0], "r");
+}
+
 inline struct res exec(const std::string& cmd, const std::string& output_name) {
+  auto start = std::chrono::steady_clock::now();
   int pid;
   auto fp = command::open(cmd, pid, output_name);
   if (!fp) return {-1, ""};
   auto output = command::read(fp);
   auto stat = command::close(fp, pid);
+  if (const auto& stats = Telemetry::current()) {
+    stats->exec.record(std::chrono::steady_clock::now() - start);
+  }
   return {WEXITSTATUS(stat), output};
 }
 
@@ -141,30 +166,20 @@ inline struct res execNoRead(const std::string& cmd) {
 inline int32_t forkExec(const std::string& cmd) {
   if (cmd == "") return -1;
 
-  pid_t pid = fork();
+  // Commands started by the user outlive Waybar
+  pid_t pid = spawn(cmd);
 
   if (pid < 0) {
     spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
     return pid;
   }
-
-  // Child executes the command
-  if (!pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in forkExec failed: {}", strerror(err));
-    setpgid(pid, pid);
-    execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    reap_mtx.lock();
-    reap.push_back(pid);
-    reap_mtx.unlock();
-    spdlog::debug("Added child to reap list: {}", pid);
+  if (const auto& stats = Telemetry::current()) {
+    stats->forks++;
   }
+  reap_mtx.lock();
+  reap.push_back(pid);
+  reap_mtx.unlock();
+  spdlog::debug("Added child to reap list: {}", pid);
 
   return pid;
 }
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glibmm/main.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace waybar::util {
+
+/**
+ * Unix socket through which other programs drive the bar, one request per line.
+ *
+ * Requests are read on the main loop and answered with one line each, in order. A client may
+ * write many requests at once: they are all handled before `flush` runs, so a module pushed to
+ * a hundred times in one write is redrawn once. Replies the client doesn't read right away are
+ * queued, and sent when its socket is writable again.
+ */
+class ControlSocket {
+ public:
+  struct Request {
+    std::string command;
+    // Module reference as in the config, e.g. "custom/vpn"
+    std::string module;
+    // Output the module is addressed on, empty for every bar
+    std::string output;
+    // Rest of the line
+    std::string argument;
+  };
+
+  // Answer `request` with one line, without its newline
+  using Handler = std::function<std::string(const Request& request)>;
+
+  /**
+   * Listen on `path`, replacing a stale socket left there. Throws std::runtime_error if it can't
+   * be bound, or another Waybar listens on it already.
+   */
+  ControlSocket(std::string path, Handler handler, std::function<void()> flush);
+  ~ControlSocket();
+  ControlSocket(const ControlSocket&) = delete;
+  ControlSocket& operator=(const ControlSocket&) = delete;
+
+  const std::string& path() const { return path_; }
+
+  // $XDG_RUNTIME_DIR/waybar-$WAYLAND_DISPLAY.sock, empty without XDG_RUNTIME_DIR
+  static std::string defaultPath();
+
+  // Split `<command> [<module>[@<output>] [<argument>]]`, nullopt for an empty line
+  static std::optional<Request> parse(std::string_view line);
+
+ private:
+  struct Connection {
+    int fd = -1;
+    // Request not terminated by a newline yet
+    std::string buffer;
+    sigc::connection io;
+    // Replies not sent yet, and the watch sending them once the socket is writable
+    std::string replies;
+    sigc::connection write_io;
+    // The client stopped writing, it is disconnected once its replies are sent
+    bool closing = false;
+  };
+
+  bool onAccept(Glib::IOCondition condition);
+  bool onReadable(int fd, Glib::IOCondition condition);
+  bool onWritable(int fd, Glib::IOCondition condition);
+  // Send what the socket takes of the replies, false if the client is gone or doesn't read
+  bool sendReplies(Connection& connection);
+  void disconnect(int fd);
+
+  const std::string path_;
+  Handler handler_;
+  std::function<void()> flush_;
+  int fd_ = -1;
+  sigc::connection accept_;
+  std::map<int, Connection> connections_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glibmm/dispatcher.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace waybar::util {
+
+/**
+ * Glib::Dispatcher remembering when it was first emitted since it was last handled, so the time
+ * an update waited in the main loop queue can be measured.
+ *
+ * emit() hides the non-virtual Glib::Dispatcher::emit(): emit through this type, not through a
+ * reference to the base class, to have the latency recorded.
+ */
+class Dispatcher : public Glib::Dispatcher {
+ public:
+  void emit() {
+    int64_t idle = 0;
+    pending_since_.compare_exchange_strong(idle, now(), std::memory_order_relaxed);
+    Glib::Dispatcher::emit();
+  }
+
+  // Time since the oldest emit not handled yet, or zero if there is none
+  std::chrono::steady_clock::duration takeLatency() {
+    auto since = pending_since_.exchange(0, std::memory_order_relaxed);
+    if (since == 0) {
+      return {};
+    }
+    return std::chrono::steady_clock::duration(now() - since);
+  }
+
+ private:
+  static int64_t now() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+  std::atomic<int64_t> pending_since_ = 0;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "util/command.hpp"
+
+namespace waybar::util {
+
+/**
+ * Results of the commands modules execute, shared by every module and bar running the same one.
+ *
+ * A command is keyed by its text and output name. Callers asking for a command that is running
+ * wait for that run instead of starting another, and a result younger than the TTL of the
+ * caller is returned without running anything. Hits, joins and misses are counted in the module
+ * stats.
+ */
+class ExecCache {
+ public:
+  static ExecCache& inst();
+
+  // Result of `cmd`, at most `ttl` old
+  command::res exec(const std::string& cmd, const std::string& output_name,
+                    std::chrono::milliseconds ttl);
+
+  // "exec-cache" of `config`: a TTL in seconds, or true to only join running commands
+  static std::optional<std::chrono::milliseconds> ttl(const Json::Value& config);
+
+ private:
+  struct Entry {
+    command::res result;
+    std::optional<std::chrono::steady_clock::time_point> done_at;
+    bool running = false;
+    // Completed runs, waiters tell a finished run from a cancelled one with it
+    uint64_t runs = 0;
+  };
+
+  ExecCache() = default;
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  // Never shrinks, there are as many entries as commands in the config
+  std::map<std::pair<std::string, std::string>, Entry> entries_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Format string parsed once into literal text and replacement fields.
+ *
+ * A module binds the name of every field to a slot of its own (eg. "usage3" to the usage of
+ * core 3) when the template is compiled, then renders by appending the value of each field into
+ * a reused buffer. Values the format does not reference are never computed, and no argument
+ * store is built on update.
+ */
+class FormatTemplate {
+ public:
+  struct Field {
+    // Argument name, positional fields are named after their index ("0", "1", ...)
+    std::string name;
+    // Format string applying the spec of the field to a single value, eg. "{:>3}"
+    std::string spec;
+    // Set by the binder, -1 if the name is unknown
+    int slot = -1;
+    size_t index = 0;
+
+    template <typename T>
+    void append(std::string& out, const T& value) const {
+      if (spec.empty()) {
+        fmt::format_to(std::back_inserter(out), "{}", value);
+      } else {
+        fmt::format_to(std::back_inserter(out), fmt::runtime(spec), value);
+      }
+    }
+  };
+
+  /**
+   * Resolve a field name to a slot, and optionally an index (eg. a core number).
+   * Returns -1 for names the module does not provide.
+   */
+  using Binder = std::function<int(std::string_view name, size_t& index)>;
+
+  FormatTemplate() = default;
+  // Throws fmt::format_error if `format` is not a valid format string
+  explicit FormatTemplate(std::string_view format, const Binder& bind = nullptr);
+
+  bool empty() const { return pieces_.empty(); }
+  bool uses(std::string_view name) const;
+  bool usesSlot(int slot) const;
+  const std::vector<Field>& fields() const { return fields_; }
+
+  /**
+   * Render into `out`, which is cleared first.
+   * `append(field, out)` appends the value of `field`, typically with `field.append(out, value)`.
+   */
+  template <typename Append>
+  void render(std::string& out, Append&& append) const {
+    out.clear();
+    for (const auto& piece : pieces_) {
+      if (piece.field < 0) {
+        out.append(literals_, piece.offset, piece.size);
+      } else {
+        append(fields_[piece.field], out);
+      }
+    }
+  }
+
+  // Error for a field bound to no slot, matching fmt's message for a missing argument
+  [[noreturn]] static void unknownField(const Field& field);
+
+ private:
+  struct Piece {
+    // Index into fields_, or -1 for the literal literals_[offset, offset + size)
+    int field;
+    size_t offset;
+    size_t size;
+  };
+
+  std::string literals_;
+  std::vector<Piece> pieces_;
+  std::vector<Field> fields_;
+};
+
+}  // namespace waybar::util
@@ -3,11 +3,12 @@
 #include <fmt/ostream.h>
 #include <json/json.h>
 
-#include <algorithm>
-#include <codecvt>
-#include <iostream>
-#include <locale>
-#include <regex>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #if (FMT_VERSION >= 90000)
 
@@ -18,30 +19,72 @@ struct fmt::formatter<Json::Value> : ostream_formatter {};
 
 namespace waybar::util {
 
+/**
+ * Parses JSON straight from the buffer it is given, with one reader kept for every call.
+ *
+ * "\x" escapes, which some programs print but JSON doesn't allow, are read as "\u00". The input
+ * is only copied when it contains one. Calls may come from several threads: they are serialized.
+ */
 class JsonParser {
  public:
-  JsonParser() = default;
+  JsonParser() : m_reader(Json::CharReaderBuilder().newCharReader()) {}
 
-  Json::Value parse(const std::string& jsonStr) {
-    Json::Value root;
+  Json::Value parse(std::string_view json) {
+    if (!hasHexadecimalEscape(json)) {
+      return parseBuffer(json.data(), json.data() + json.size());
+    }
+    std::string modifiedJson = replaceHexadecimalEscape(json);
+    return parseBuffer(modifiedJson.data(), modifiedJson.data() + modifiedJson.size());
+  }
 
-    // replace all occurrences of "\x" with "\u00", because JSON doesn't allow "\x" escape sequences
-    std::string modifiedJsonStr = replaceHexadecimalEscape(jsonStr);
+ private:
+  std::mutex m_mutex;
+  std::unique_ptr<Json::CharReader> m_reader;
 
-    std::istringstream jsonStream(modifiedJsonStr);
+  Json::Value parseBuffer(const char* begin, const char* end) {
+    Json::Value root;
     std::string errs;
-    if (!Json::parseFromStream(m_readerBuilder, jsonStream, &root, &errs)) {
+    std::lock_guard lock(m_mutex);
+    if (!m_reader->parse(begin, end, &root, &errs)) {
       throw std::runtime_error("Error parsing JSON: " + errs);
     }
     return root;
   }
 
- private:
-  Json::CharReaderBuilder m_readerBuilder;
+  // Position of the next "\x" escape at or after `pos`, npos if there is none
+  static size_t findHexadecimalEscape(std::string_view str, size_t pos) {
+    while (pos < str.size()) {
+      const auto* found =
+          static_cast<const char*>(std::memchr(str.data() + pos, '\\', str.size() - pos));
+      if (found == nullptr) {
+        return std::string_view::npos;
+      }
+      pos = found - str.data();
+      if (pos + 1 < str.size() && str[pos + 1] == 'x') {
+        return pos;
+      }
+      // Skips the escaped character, so that "\\x" stays a backslash followed by an x
+      pos += 2;
+    }
+    return std::string_view::npos;
+  }
 
-  static std::string replaceHexadecimalEscape(const std::string& str) {
-    static std::regex re("\\\\x");
-    return std::regex_replace(str, re, "\\u00");
+  static bool hasHexadecimalEscape(std::string_view str) {
+    return findHexadecimalEscape(str, 0) != std::string_view::npos;
+  }
+
+  static std::string replaceHexadecimalEscape(std::string_view str) {
+    std::string result;
+    result.reserve(str.size() + 16);
+    size_t start = 0;
+    size_t pos;
+    while ((pos = findHexadecimalEscape(str, start)) != std::string_view::npos) {
+      result.append(str.substr(start, pos - start));
+      result.append("\\u00");
+      start = pos + 2;
+    }
+    result.append(str.substr(start));
+    return result;
   }
 };
 }  // namespace waybar::util
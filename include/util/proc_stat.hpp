@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Idle and total jiffies per cpu, as a structure of arrays.
+ * Index 0 holds the sum over all cpus, index N + 1 holds cpuN. Offline cpus are zeroed.
+ */
+struct CpuTimes {
+  std::vector<uint64_t> idle;
+  std::vector<uint64_t> total;
+
+  size_t size() const { return total.size(); }
+};
+
+/**
+ * Reader for the cpu lines of /proc/stat.
+ *
+ * The files are kept open and re-read with pread() into a reused buffer, numbers are parsed with
+ * std::from_chars and written into the caller's CpuTimes, so that a steady-state read does not
+ * allocate.
+ */
+class ProcStat {
+ public:
+  explicit ProcStat(std::string path = "/proc/stat",
+                    std::string present_path = "/sys/devices/system/cpu/present");
+  ~ProcStat();
+  ProcStat(const ProcStat&) = delete;
+  ProcStat& operator=(const ProcStat&) = delete;
+
+  // Read the current counters into `times`. Throws std::runtime_error if /proc/stat is unreadable.
+  void read(CpuTimes& times);
+
+  /**
+   * Parse the contents of /proc/stat into `times`.
+   * `present_last` is the highest cpu number that exists, cpus missing after the last line of
+   * the file are filled in up to it.
+   */
+  static void parse(std::string_view data, size_t present_last, CpuTimes& times);
+
+ private:
+  size_t readPresentLast();
+  static std::string_view readAll(int fd, std::vector<char>& buffer);
+
+  const std::string path_;
+  const std::string present_path_;
+  int fd_ = -1;
+  int present_fd_ = -1;
+  std::vector<char> buffer_;
+  std::vector<char> present_buffer_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "util/telemetry.hpp"
+
+namespace waybar::util {
+
+/**
+ * One thread reading the stdout of every continuous script, and the files custom modules watch.
+ *
+ * Each watched command runs with a non-blocking pipe as stdout, multiplexed with epoll into a
+ * line buffer of its own. Complete lines are handed to the watcher; an exit is noticed through a
+ * pidfd (where available), the child is reaped and, with a restart interval, started again when
+ * the interval elapsed. Twenty streaming scripts cost one parked thread instead of twenty.
+ *
+ * Watched files are re-read when inotify reports they were written to, named pipes are read
+ * line by line like the stdout of a command.
+ */
+class ProcessReactor {
+ public:
+  struct Command {
+    std::string cmd;
+    // Exported as WAYBAR_OUTPUT_NAME if not empty
+    std::string output_name;
+    // Start the command again this long after it exited, never if unset
+    std::optional<std::chrono::milliseconds> restart_interval;
+  };
+
+  /**
+   * Callbacks run on the reactor thread, with the reactor locked: they must be short (publish the
+   * line and emit a dispatcher) and must not call into the reactor.
+   */
+  struct Handler {
+    // A line of output, without its newline
+    std::function<void(std::string line)> line;
+    // The command exited with `exit_code`, or could not be started again (-1)
+    std::function<void(int exit_code)> exit;
+  };
+
+  // Called like Handler with each line of a named pipe, or the content of a regular file
+  using FileHandler = std::function<void(std::string content)>;
+
+  // Stops watching, and kills the command, when destroyed or reset
+  class Watch {
+   public:
+    Watch() = default;
+    Watch(Watch&& other) noexcept : id_(std::exchange(other.id_, 0)) {}
+    Watch& operator=(Watch&& other) noexcept;
+    ~Watch() { reset(); }
+    void reset();
+
+   private:
+    friend class ProcessReactor;
+    explicit Watch(uint64_t id) : id_(id) {}
+    uint64_t id_ = 0;
+  };
+
+  static ProcessReactor& inst();
+
+  // Start `command` and watch its output. Throws std::runtime_error if it can't be started.
+  Watch watch(Command command, Handler handler);
+
+  /**
+   * Hand the content of the file at `path`, without its last newline, to `handler`: now, then
+   * every time a writer closes it, it is replaced or removed (as an empty content). A named pipe
+   * is read instead, one line at a time. Throws std::runtime_error if it can't be watched.
+   */
+  Watch watchFile(const std::string& path, FileHandler handler);
+
+  // Number of watched commands, running or waiting to be restarted, and files
+  size_t size() const;
+
+ private:
+  struct Child {
+    Command command;
+    Handler handler;
+    // Module the restarts are attributed to
+    std::shared_ptr<ModuleStats> stats;
+    pid_t pid = -1;
+    // Read end of the stdout pipe, -1 once it reached EOF
+    int out = -1;
+    // -1 if the kernel has no pidfd, the exit is then polled for
+    int pidfd = -1;
+    // Output not terminated by a newline yet
+    std::string buffer;
+    // Set while waiting for the restart interval
+    std::optional<std::chrono::steady_clock::time_point> restart_at;
+    // Exited and not to be restarted
+    bool done = false;
+  };
+
+  struct File {
+    std::string path;
+    // Name of the file in its directory, the directory is what inotify watches
+    std::string name;
+    FileHandler handler;
+    // The inotify instance, or the named pipe
+    int fd = -1;
+    bool fifo = false;
+    // Line of a named pipe not terminated yet
+    std::string buffer;
+  };
+
+  ProcessReactor();
+  ~ProcessReactor() = delete;
+
+  void run();
+  // Start the command of `child` and register its descriptors, false on failure
+  bool start(uint64_t id, Child& child);
+  void remove(uint64_t id);
+  // Read what was written to `fd`, handing out complete lines. Returns false once it reached EOF.
+  static bool drain(int fd, std::string& buffer, const std::function<void(std::string)>& line);
+  // Read the pending inotify events of `file`, true if they are about the file itself
+  static bool changed(File& file);
+  // Reap `child` if it exited, then schedule its restart or mark it done
+  static void reap(Child& child, bool block);
+  // Time epoll_wait() may sleep for, -1 for no limit
+  int timeout() const;
+  void wakeUp() const;
+
+  int epoll_fd_ = -1;
+  // Interrupts epoll_wait() to recompute its timeout
+  int event_fd_ = -1;
+  mutable std::mutex mutex_;
+  uint64_t next_id_ = 1;
+  std::map<uint64_t, Child> children_;
+  std::map<uint64_t, File> files_;
+  // Killed children not reaped yet
+  std::vector<pid_t> orphans_;
+  std::thread thread_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <json/json.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/dispatcher.hpp"
+#include "util/scheduler.hpp"
+#include "util/sleeper_thread.hpp"
+
+namespace waybar::util {
+
+/**
+ * Data source shared by every module instance with the same type and configuration.
+ *
+ * With several outputs each bar builds its own copy of a module. A provider lets these copies
+ * sample (or exec) once: the provider publishes its result and wakes the dispatcher of every
+ * attached module, the modules themselves only render.
+ */
+class Provider {
+ public:
+  virtual ~Provider() = default;
+
+  void attach(Dispatcher& dp);
+  void detach(Dispatcher& dp);
+  size_t subscribers() const;
+  // Number of samples taken since the provider was created
+  uint64_t samples() const { return samples_; }
+
+  /**
+   * Get the provider shared by modules of `type` with an identical `config`, creating it with
+   * `make` when no module holds one yet.
+   */
+  template <typename T>
+  static std::shared_ptr<T> get(const std::string& type, const Json::Value& config,
+                                const std::function<std::shared_ptr<T>()>& make) {
+    auto key = makeKey(type, config);
+    std::lock_guard lock(registryMutex());
+    if (auto existing = std::dynamic_pointer_cast<T>(lookup(key))) {
+      return existing;
+    }
+    auto created = make();
+    store(key, created);
+    return created;
+  }
+
+ protected:
+  // Wake every attached module, to be called after a new sample was published
+  void notify();
+
+  std::atomic<uint64_t> samples_ = 0;
+
+ private:
+  static std::string makeKey(const std::string& type, const Json::Value& config);
+  static std::mutex& registryMutex();
+  static std::shared_ptr<Provider> lookup(const std::string& key);
+  static void store(const std::string& key, const std::shared_ptr<Provider>& provider);
+
+  mutable std::mutex dispatchers_mutex_;
+  std::vector<Dispatcher*> dispatchers_;
+};
+
+/**
+ * Provider running a sampling function on its own worker at every interval tick and keeping the
+ * result as an immutable snapshot. Modules read the snapshot in update() and never touch the
+ * underlying kernel interfaces from the GTK main loop; the scheduler only wakes the worker, so a
+ * sampler stuck on a slow file system doesn't hold up the other subscriptions.
+ */
+template <typename T>
+class SampledProvider : public Provider {
+ public:
+  using Sampler = std::function<T()>;
+
+  SampledProvider(std::chrono::milliseconds interval, Sampler sampler)
+      : sampler_(std::move(sampler)) {
+    thread_ = [this] {
+      sample();
+      thread_.sleep();
+    };
+    timer_ = Scheduler::inst().schedule(
+        interval, [this] { thread_.wake_up(); }, false);
+  }
+  ~SampledProvider() override { timer_.reset(); }
+
+  /**
+   * Get the provider shared by all `type` modules polling every `interval`.
+   * `sampler` is only used if the provider has to be created.
+   */
+  static std::shared_ptr<SampledProvider> get(const std::string& type,
+                                              std::chrono::milliseconds interval,
+                                              Sampler sampler) {
+    return Provider::get<SampledProvider>(
+        type, Json::Value(static_cast<Json::Int64>(interval.count())),
+        [&interval, &sampler] { return std::make_shared<SampledProvider>(interval, sampler); });
+  }
+
+  // Latest sample, or nullptr before the first one completed
+  std::shared_ptr<const T> snapshot() const {
+    std::lock_guard lock(snapshot_mutex_);
+    return snapshot_;
+  }
+
+ private:
+  void sample() {
+    std::shared_ptr<const T> next;
+    try {
+      next = std::make_shared<const T>(sampler_());
+    } catch (const std::exception& e) {
+      spdlog::error("Sampling failed: {}", e.what());
+      return;
+    }
+    {
+      std::lock_guard lock(snapshot_mutex_);
+      snapshot_ = std::move(next);
+    }
+    samples_++;
+    notify();
+  }
+
+  Sampler sampler_;
+  mutable std::mutex snapshot_mutex_;
+  std::shared_ptr<const T> snapshot_;
+  Scheduler::Subscription timer_;
+  // Last, so that it stops before the members it samples into go away
+  SleeperThread thread_;
+};
+
+}  // namespace waybar::util
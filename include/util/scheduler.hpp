@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Process-wide timer scheduler for interval modules.
+ *
+ * All subscribers share one thread blocked on a single timerfd. Deadlines are aligned to
+ * multiples of the subscription interval on the wall clock, so every module that uses the same
+ * interval is woken by the same tick. A coalescing slack lets a tick wait for the subscriptions
+ * due within the slack window after it, merging nearby deadlines into one wakeup. No subscription
+ * fires before its deadline.
+ *
+ * Callbacks run on the scheduler thread and must be cheap (typically `dp.emit()` or waking a
+ * module's own worker thread).
+ */
+class Scheduler {
+ public:
+  using Callback = std::function<void()>;
+  using clock = std::chrono::system_clock;
+
+  struct Stats {
+    // timerfd expirations handled by the scheduler thread
+    uint64_t wakeups = 0;
+    // callbacks fired across all wakeups
+    uint64_t callbacks = 0;
+    // callbacks fired by the most recent wakeup
+    uint64_t last_tick_callbacks = 0;
+    // number of live subscriptions
+    size_t subscriptions = 0;
+  };
+
+  /**
+   * RAII handle for a scheduled callback.
+   * Destroying (or resetting) it cancels the subscription and waits for an in-flight call.
+   */
+  class Subscription {
+   public:
+    Subscription() = default;
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+    Subscription(Subscription&& other) noexcept;
+    Subscription& operator=(Subscription&& other) noexcept;
+    ~Subscription() { reset(); }
+
+    void reset();
+    // Fire the callback on the next scheduler iteration, independently of the interval.
+    void trigger() const;
+    explicit operator bool() const { return scheduler_ != nullptr; }
+
+   private:
+    friend class Scheduler;
+    Subscription(Scheduler* scheduler, uint64_t id) : scheduler_(scheduler), id_(id) {}
+
+    Scheduler* scheduler_ = nullptr;
+    uint64_t id_ = 0;
+  };
+
+  static Scheduler& inst();
+
+  Scheduler();
+  ~Scheduler();
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  /**
+   * Call `cb` on every interval boundary, and once right away unless `immediate` is false.
+   * An interval of `std::chrono::milliseconds::max()` (the "once" interval) fires only once, and
+   * then only on Subscription::trigger().
+   */
+  [[nodiscard]] Subscription schedule(std::chrono::milliseconds interval, Callback cb,
+                                      bool immediate = true);
+
+  // Maximum delay accepted to merge a deadline into an earlier wakeup.
+  void setSlack(std::chrono::milliseconds slack);
+  std::chrono::milliseconds slack() const { return slack_.load(); }
+
+  Stats stats() const;
+
+ private:
+  struct Task {
+    std::chrono::milliseconds interval;
+    clock::time_point deadline;
+    std::shared_ptr<Callback> cb;
+  };
+  using Entry = std::pair<clock::time_point, uint64_t>;
+
+  void cancel(uint64_t id);
+  void trigger(uint64_t id);
+  void run();
+  void wake();
+  void armTimer();
+  void realign(clock::time_point now);
+  static clock::time_point nextDeadline(clock::time_point now, std::chrono::milliseconds interval);
+
+  mutable std::mutex mutex_;
+  // Held while callbacks run, so that cancel() can wait for an in-flight call.
+  std::mutex run_mutex_;
+  std::unordered_map<uint64_t, Task> tasks_;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue_;
+  std::vector<std::shared_ptr<Callback>> due_;
+  uint64_t next_id_ = 1;
+  std::atomic<std::chrono::milliseconds> slack_{std::chrono::milliseconds(0)};
+  Stats stats_;
+
+  int timer_fd_ = -1;
+  int event_fd_ = -1;
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+
+}  // namespace waybar::util
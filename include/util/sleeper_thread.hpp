@@ -7,6 +7,7 @@
 #include <thread>
 
 #include "prepare_for_sleep.h"
+#include "util/telemetry.hpp"
 
 namespace waybar::util {
 
@@ -30,24 +31,14 @@ class SleeperThread {
   SleeperThread() = default;
 
   SleeperThread(std::function<void()> func)
-      : thread_{[this, func] {
-          while (do_run_) {
-            signal_ = false;
-            func();
-          }
-        }} {
+      : thread_{[this, func, stats = Telemetry::current()] { run(func, stats); }} {
     connection_ = prepare_for_sleep().connect([this](bool sleep) {
       if (not sleep) wake_up();
     });
   }
 
   SleeperThread& operator=(std::function<void()> func) {
-    thread_ = std::thread([this, func] {
-      while (do_run_) {
-        signal_ = false;
-        func();
-      }
-    });
+    thread_ = std::thread([this, func, stats = Telemetry::current()] { run(func, stats); });
     if (connection_.empty()) {
       connection_ = prepare_for_sleep().connect([this](bool sleep) {
         if (not sleep) wake_up();
@@ -59,12 +50,14 @@ class SleeperThread {
   bool isRunning() const { return do_run_; }
 
   auto sleep() {
+    SleepTimer timer;
     std::unique_lock lk(mutex_);
     CancellationGuard cancel_lock;
     return condvar_.wait(lk, [this] { return signal_ || !do_run_; });
   }
 
   auto sleep_for(std::chrono::system_clock::duration dur) {
+    SleepTimer timer;
     std::unique_lock lk(mutex_);
     CancellationGuard cancel_lock;
     constexpr auto max_time_point = std::chrono::steady_clock::time_point::max();
@@ -79,6 +72,7 @@ class SleeperThread {
   auto sleep_until(
       std::chrono::time_point<std::chrono::system_clock, std::chrono::system_clock::duration>
           time_point) {
+    SleepTimer timer;
     std::unique_lock lk(mutex_);
     CancellationGuard cancel_lock;
     return condvar_.wait_until(lk, time_point, [this] { return signal_ || !do_run_; });
@@ -106,15 +100,43 @@ class SleeperThread {
     }
   }
 
-  ~SleeperThread() {
-    connection_.disconnect();
+  // Stop the thread and wait for it to exit, before its owner releases what it uses
+  void join() {
     stop();
     if (thread_.joinable()) {
       thread_.join();
     }
   }
 
+  ~SleeperThread() {
+    connection_.disconnect();
+    join();
+  }
+
  private:
+  // Run `func` until stopped, recording the busy time of every iteration in `stats`
+  void run(const std::function<void()>& func, const std::shared_ptr<ModuleStats>& stats) {
+    Telemetry::Scope scope(stats);
+    while (do_run_) {
+      signal_ = false;
+      slept_ = {};
+      auto start = std::chrono::steady_clock::now();
+      func();
+      if (stats) {
+        stats->worker.record(std::chrono::steady_clock::now() - start - slept_);
+      }
+    }
+  }
+
+  // Add the time spent in a sleep*() call to the current iteration's sleep time
+  struct SleepTimer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ~SleepTimer() { slept_ += std::chrono::steady_clock::now() - start; }
+  };
+
+  // Sleep time of the current iteration, per thread as sleep*() runs on the worker thread
+  static inline thread_local std::chrono::steady_clock::duration slept_{};
+
   std::thread thread_;
   std::condition_variable condvar_;
   std::mutex mutex_;
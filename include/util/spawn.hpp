@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+// "direct-exec" of the config, the default of SpawnOptions::direct. Off unless a bar enables it
+void setDirectExec(bool enabled);
+bool directExec();
+
+struct SpawnOptions {
+  // Descriptor the child uses as stdout, -1 to inherit ours
+  int stdout_fd = -1;
+  // Descriptor the child uses as stdin, -1 to inherit ours
+  int stdin_fd = -1;
+  // Signal sent to the child when the spawning thread exits, 0 to let it outlive Waybar
+  int deathsig = 0;
+  // Exported to the child as WAYBAR_OUTPUT_NAME if not empty
+  std::string output_name;
+  // Execute commands /bin/sh would only split on blanks without starting a shell. Files execve()
+  // can't run, such as scripts without a shebang, still go through /bin/sh. Follows "direct-exec".
+  bool direct = directExec();
+};
+
+/**
+ * Start `cmd` as with `/bin/sh -c cmd`, in its own process group and with an empty signal mask.
+ *
+ * The child is created with clone(CLONE_VM | CLONE_VFORK) (vfork() elsewhere): it borrows our
+ * address space until it execs, so the cost does not grow with the RSS of Waybar like fork()
+ * copying the page tables does.
+ *
+ * Returns the pid of the child, or -1 with errno set if it could not be started.
+ */
+pid_t spawn(const std::string& cmd, const SpawnOptions& options = {});
+
+// Words of `cmd` if it needs no shell to run, nullopt if it has to go through /bin/sh
+std::optional<std::vector<std::string>> splitSimpleCommand(std::string_view cmd);
+
+// Path `name` resolves to through PATH, nullopt if there is no such executable
+std::optional<std::string> findExecutable(const std::string& name);
+
+}  // namespace waybar::util
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <sys/statvfs.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/dispatcher.hpp"
+#include "util/proc_stat.hpp"
+#include "util/scheduler.hpp"
+
+namespace waybar::util {
+
+/**
+ * Shared sampler for the kernel counters of the system modules: /proc/stat, /proc/meminfo, the
+ * load average, hwmon and thermal zone inputs, statvfs() of mount points and /proc/net/dev.
+ *
+ * Subscribers polling at the same interval share a group. At every tick the group reads the
+ * union of the sources its subscribers asked for in one pass on its worker thread, then
+ * publishes an immutable, versioned snapshot. Subscribers are only woken when one of their
+ * sources changed, and compare versions to skip rendering an unchanged snapshot.
+ */
+class SystemSampler {
+ public:
+  enum Field : uint32_t {
+    STAT = 1 << 0,
+    MEMINFO = 1 << 1,
+    LOADAVG = 1 << 2,
+    INPUTS = 1 << 3,
+    MOUNTS = 1 << 4,
+    NETDEV = 1 << 5,
+  };
+  static constexpr size_t FIELD_COUNT = 6;
+
+  using Meminfo = std::unordered_map<std::string, unsigned long>;
+
+  // Integer content of an input file, eg. millidegrees Celsius of a hwmon temp*_input
+  struct Input {
+    int64_t value = 0;
+    uint64_t changed = 0;
+  };
+
+  struct Mount {
+    struct statvfs stats {};
+    uint64_t changed = 0;
+  };
+
+  struct NetDev {
+    unsigned long long received = 0;
+    unsigned long long transmitted = 0;
+
+    bool operator==(const NetDev&) const = default;
+  };
+
+  struct Snapshot {
+    uint64_t version = 0;
+    // When the pass started, rates are computed over the time between two snapshots
+    std::chrono::steady_clock::time_point taken;
+    // Version of the snapshot in which each field last changed, indexed by the bit of the field
+    std::array<uint64_t, FIELD_COUNT> changed{};
+
+    CpuTimes stat;
+    Meminfo meminfo;
+    std::optional<std::array<double, 3>> loadavg;
+    // Keyed by path, a source missing here could not be read
+    std::map<std::string, Input> inputs;
+    std::map<std::string, Mount> mounts;
+    // Keyed by interface name
+    std::map<std::string, NetDev> netdev;
+
+    // Whether any of `fields` changed after snapshot `version`
+    bool changedSince(uint32_t fields, uint64_t version) const;
+  };
+
+  struct Request {
+    uint32_t fields = 0;
+    // Files for INPUTS, paths for MOUNTS
+    std::vector<std::string> inputs;
+    std::vector<std::string> mounts;
+    // Platform readers for STAT and MEMINFO, only used if the group has none yet
+    std::function<void(CpuTimes&)> read_stat;
+    std::function<void(Meminfo&)> read_meminfo;
+  };
+
+  class Group;
+
+  /**
+   * RAII handle of a subscriber. Destroying (or resetting) it removes the subscriber, the group
+   * stops sampling once its last subscriber is gone.
+   */
+  class Subscription {
+   public:
+    Subscription() = default;
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+    Subscription(Subscription&& other) noexcept;
+    Subscription& operator=(Subscription&& other) noexcept;
+    ~Subscription() { reset(); }
+
+    void reset();
+    // Latest snapshot, or nullptr before the first pass completed
+    std::shared_ptr<const Snapshot> snapshot() const;
+    explicit operator bool() const { return group_ != nullptr; }
+
+   private:
+    friend class SystemSampler;
+    Subscription(std::shared_ptr<Group> group, uint64_t id) : group_(std::move(group)), id_(id) {}
+
+    std::shared_ptr<Group> group_;
+    uint64_t id_ = 0;
+  };
+
+  static SystemSampler& inst();
+
+  /**
+   * Sample the sources of `request` every `interval`. `dp` (if not null) is emitted after every
+   * pass that changed one of them.
+   */
+  [[nodiscard]] Subscription subscribe(std::chrono::milliseconds interval, Request request,
+                                       Dispatcher* dp);
+
+  // Number of groups currently sampling, one per distinct interval
+  size_t groups() const;
+
+ private:
+  void release(const std::shared_ptr<Group>& group, uint64_t id);
+
+  mutable std::mutex mutex_;
+  std::map<std::chrono::milliseconds, std::shared_ptr<Group>> groups_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Lock-free histogram of durations with power of two microsecond buckets.
+ *
+ * Bucket 0 holds durations below 1µs, bucket i durations in [2^(i-1), 2^i) µs and the last one
+ * everything above. Percentiles are estimated as the upper bound of their bucket.
+ */
+class Histogram {
+ public:
+  static constexpr size_t BUCKETS = 28;
+
+  void record(std::chrono::steady_clock::duration duration);
+
+  uint64_t count() const { return count_; }
+  std::chrono::microseconds sum() const { return std::chrono::microseconds(sum_us_); }
+  std::chrono::microseconds max() const { return std::chrono::microseconds(max_us_); }
+  // Upper bound of the bucket holding the `quantile` (0 to 1) of the recorded durations
+  std::chrono::microseconds percentile(double quantile) const;
+
+  Json::Value toJson() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<uint64_t> sum_us_ = 0;
+  std::atomic<uint64_t> max_us_ = 0;
+};
+
+/**
+ * Counters of one module instance. Written from the main loop and the module's own threads.
+ */
+struct ModuleStats {
+  ModuleStats(std::string name, std::string output)
+      : name(std::move(name)), output(std::move(output)) {}
+
+  const std::string name;
+  const std::string output;
+  // Duration of update() on the main loop
+  Histogram update;
+  // Time between the first dp.emit() and the update() handling it
+  Histogram dispatch_latency;
+  // Busy time of one worker thread iteration, sleeps excluded
+  Histogram worker;
+  // Wall time of util::command::exec
+  Histogram exec;
+  // Processes forked by util::command
+  std::atomic<uint64_t> forks = 0;
+  // Commands answered by util::ExecCache with a recent result, or with the result of a run
+  // another module had started, and those it had to run
+  std::atomic<uint64_t> exec_hits = 0;
+  std::atomic<uint64_t> exec_joined = 0;
+  std::atomic<uint64_t> exec_misses = 0;
+  // Outputs replaced by a newer one before they were shown
+  std::atomic<uint64_t> dropped = 0;
+  // Label and CSS class changes made to the widget, and those skipped because it already
+  // showed the same content
+  std::atomic<uint64_t> label_applied = 0;
+  std::atomic<uint64_t> label_skipped = 0;
+
+  Json::Value toJson() const;
+};
+
+/**
+ * Registry of the stats of every live module.
+ *
+ * Code attributes its cost to a module through the stats of the current thread: the bar sets
+ * them while a module is built and updated, and worker threads inherit the stats of the thread
+ * that started them.
+ */
+class Telemetry {
+ public:
+  static Telemetry& inst();
+
+  std::shared_ptr<ModuleStats> create(std::string name, std::string output);
+
+  // Stats of the module running on this thread, or nullptr
+  static const std::shared_ptr<ModuleStats>& current();
+
+  // Make `stats` current for the lifetime of the scope
+  class Scope {
+   public:
+    explicit Scope(std::shared_ptr<ModuleStats> stats);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    std::shared_ptr<ModuleStats> previous_;
+  };
+
+  Json::Value toJson() const;
+  // Log one line per module, the most expensive first
+  void log() const;
+  // Write toJson() to `path`, replacing the file atomically
+  void write(const std::string& path) const;
+
+ private:
+  Telemetry() = default;
+
+  std::vector<std::shared_ptr<ModuleStats>> modules() const;
+
+  mutable std::mutex mutex_;
+  std::vector<std::weak_ptr<ModuleStats>> modules_;
+};
+
+}  // namespace waybar::util
@@ -7,12 +7,30 @@
 extern "C" {
 #endif
 
-/// Waybar ABI version. 2 is the latest version
+/// Waybar ABI version. 3 is the latest version
+///
+/// Up to version 2, the module fills the widget returned by get_root_widget(). From version 3,
+/// Waybar shows the records the module publishes with its own label instead.
 extern const size_t wbcffi_version;
 
 /// Private Waybar CFFI module
 typedef struct wbcffi_module wbcffi_module;
 
+/// Data shown by Waybar, since ABI version 3. Any string may be NULL.
+typedef struct {
+  /// Pango markup replacing {text} in the "format" of the module. Empty hides the module.
+  const char* text;
+  /// Replaces {alt}, and selects the "format-icons" entry for {icon}
+  const char* alt;
+  /// Tooltip markup, unless the config has a "tooltip-format"
+  const char* tooltip;
+  /// CSS classes of the label
+  const char* const* classes;
+  size_t classes_len;
+  /// 0 to 100, replaces {percentage} and selects the icon and the "states" class
+  int percentage;
+} wbcffi_record;
+
 /// Waybar module information
 typedef struct {
   /// Waybar CFFI object pointer
@@ -21,7 +39,7 @@ typedef struct {
   /// Waybar version string
   const char* waybar_version;
 
-  /// Returns the waybar widget allocated for this module
+  /// Returns the waybar widget allocated for this module, NULL from ABI version 3
   /// @param obj Waybar CFFI object pointer
   GtkContainer* (*get_root_widget)(wbcffi_module* obj);
 
@@ -29,6 +47,14 @@ typedef struct {
   /// loop iteration
   /// @param obj Waybar CFFI object pointer
   void (*queue_update)(wbcffi_module*);
+
+  /// Shows `record` on the next GTK main event loop iteration. Since ABI version 3.
+  ///
+  /// May be called from any thread, until wbcffi_deinit() returns. The record is copied, and
+  /// replaces the one published before if that one was not shown yet.
+  /// @param obj Waybar CFFI object pointer
+  /// @param record Data to show
+  void (*publish)(wbcffi_module* obj, const wbcffi_record* record);
 } wbcffi_init_info;
 
 /// Config key-value pair
@@ -11,10 +11,10 @@ AIconLabel::AIconLabel(const Json::Value &config, const std::string &name, const
     : ALabel(config, name, id, format, interval, ellipsize, enable_click, enable_scroll) {
   event_box_.remove();
   label_.unset_name();
-  label_.get_style_context()->remove_class(MODULE_CLASS);
+  label_.remove_class(MODULE_CLASS);
   box_.get_style_context()->add_class(MODULE_CLASS);
   if (!id.empty()) {
-    label_.get_style_context()->remove_class(id);
+    label_.remove_class(id);
     box_.get_style_context()->add_class(id);
   }
 
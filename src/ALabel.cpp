@@ -2,14 +2,92 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <string_view>
 #include <util/command.hpp>
 
 #include "config.hpp"
 
 namespace waybar {
 
+namespace {
+// Text and markup rendering the same characters must not compare equal
+size_t hashContent(const Glib::ustring& content, bool markup) {
+  return std::hash<std::string_view>{}(content.raw()) ^ static_cast<size_t>(markup);
+}
+}  // namespace
+
+void Label::countChange(bool applied) {
+  if (!stats_) {
+    return;
+  }
+  auto& counter = applied ? stats_->label_applied : stats_->label_skipped;
+  counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Label::changed(std::optional<size_t>& last, size_t hash) {
+  if (last == hash) {
+    countChange(false);
+    return false;
+  }
+  last = hash;
+  countChange(true);
+  return true;
+}
+
+void Label::set_text(const Glib::ustring& text) {
+  if (changed(label_hash_, hashContent(text, false))) {
+    Gtk::Label::set_text(text);
+  }
+}
+
+void Label::set_markup(const Glib::ustring& markup) {
+  if (changed(label_hash_, hashContent(markup, true))) {
+    Gtk::Label::set_markup(markup);
+  }
+}
+
+void Label::set_tooltip_text(const Glib::ustring& text) {
+  if (changed(tooltip_hash_, hashContent(text, false))) {
+    Gtk::Label::set_tooltip_text(text);
+  }
+}
+
+void Label::set_tooltip_markup(const Glib::ustring& markup) {
+  if (changed(tooltip_hash_, hashContent(markup, true))) {
+    Gtk::Label::set_tooltip_markup(markup);
+  }
+}
+
+void Label::set_has_tooltip(bool has_tooltip) {
+  // Disabling the tooltip drops its text, the next tooltip has to be applied again
+  tooltip_hash_.reset();
+  Gtk::Label::set_has_tooltip(has_tooltip);
+}
+
+void Label::add_class(const Glib::ustring& name) {
+  auto style = get_style_context();
+  if (style->has_class(name)) {
+    countChange(false);
+    return;
+  }
+  countChange(true);
+  style->add_class(name);
+}
+
+void Label::remove_class(const Glib::ustring& name) {
+  auto style = get_style_context();
+  if (!style->has_class(name)) {
+    countChange(false);
+    return;
+  }
+  countChange(true);
+  style->remove_class(name);
+}
+
 ALabel::ALabel(const Json::Value& config, const std::string& name, const std::string& id,
                const std::string& format, uint16_t interval, bool ellipsize, bool enable_click,
                bool enable_scroll)
@@ -26,11 +104,12 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
                                                           : interval) *
                                                      1000)))),
       default_format_(format_) {
+  label_.setStats(stats_);
   label_.set_name(name);
   if (!id.empty()) {
-    label_.get_style_context()->add_class(id);
+    label_.add_class(id);
   }
-  label_.get_style_context()->add_class(MODULE_CLASS);
+  label_.add_class(MODULE_CLASS);
   event_box_.add(label_);
   if (config_["max-length"].isUInt()) {
     label_.set_max_width_chars(config_["max-length"].asInt());
@@ -112,6 +191,39 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
     }
   }
 
+  if (config_["states"].isObject()) {
+    for (auto it = config_["states"].begin(); it != config_["states"].end(); ++it) {
+      if (it->isUInt() && it.key().isString()) {
+        states_.emplace_back(it.key().asString(), it->asUInt());
+      }
+    }
+    std::ranges::stable_sort(states_, std::greater<>(), &std::pair<std::string, uint8_t>::second);
+  }
+
+  // A string is a single icon, an array is indexed by percentage
+  auto resolveIcons = [](const Json::Value& value) {
+    std::vector<std::string> icons;
+    if (value.isString()) {
+      icons.push_back(value.asString());
+    } else if (value.isArray()) {
+      for (const auto& icon : value) {
+        icons.push_back(icon.isString() ? icon.asString() : "");
+      }
+    }
+    return icons;
+  };
+  const auto& format_icons = config_["format-icons"];
+  if (format_icons.isObject()) {
+    for (auto it = format_icons.begin(); it != format_icons.end(); ++it) {
+      if (it->isString() || it->isArray()) {
+        icons_[it.key().asString()] = resolveIcons(*it);
+      }
+    }
+    default_icons_ = resolveIcons(format_icons["default"]);
+  } else {
+    default_icons_ = resolveIcons(format_icons);
+  }
+
   if (config_["justify"].isString()) {
     auto justify_str = config_["justify"].asString();
     if (justify_str == "left") {
@@ -126,52 +238,59 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
 
 auto ALabel::update() -> void { AModule::update(); }
 
-std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
-  auto format_icons = config_["format-icons"];
-  if (format_icons.isObject()) {
-    if (!alt.empty() && (format_icons[alt].isString() || format_icons[alt].isArray())) {
-      format_icons = format_icons[alt];
-    } else {
-      format_icons = format_icons["default"];
-    }
+Json::Value ALabel::state() const {
+  auto state = AModule::state();
+  state["text"] = std::string(label_.get_label());
+  state["tooltip"] = std::string(label_.get_tooltip_markup());
+  state["class"] = Json::Value(Json::arrayValue);
+  for (const auto& name : label_.get_style_context()->list_classes()) {
+    state["class"].append(std::string(name));
   }
-  if (format_icons.isArray()) {
-    auto size = format_icons.size();
-    if (size != 0U) {
-      auto idx = std::clamp(percentage / ((max == 0 ? 100 : max) / size), 0U, size - 1);
-      format_icons = format_icons[idx];
-    }
+  return state;
+}
+
+const std::string& ALabel::pickIcon(const std::vector<std::string>& icons, uint16_t percentage,
+                                    uint16_t max) {
+  static const std::string none;
+  if (icons.empty()) {
+    return none;
   }
-  if (format_icons.isString()) {
-    return format_icons.asString();
+  auto size = icons.size();
+  auto step = std::max<size_t>((max == 0 ? 100 : max) / size, 1);
+  return icons[std::min<size_t>(percentage / step, size - 1)];
+}
+
+std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
+  if (!alt.empty()) {
+    auto it = icons_.find(alt);
+    if (it != icons_.end()) {
+      return pickIcon(it->second, percentage, max);
+    }
   }
-  return "";
+  return pickIcon(default_icons_, percentage, max);
 }
 
 std::string ALabel::getIcon(uint16_t percentage, const std::vector<std::string>& alts,
                             uint16_t max) {
-  auto format_icons = config_["format-icons"];
-  if (format_icons.isObject()) {
-    std::string _alt = "default";
-    for (const auto& alt : alts) {
-      if (!alt.empty() && (format_icons[alt].isString() || format_icons[alt].isArray())) {
-        _alt = alt;
-        break;
-      }
+  for (const auto& alt : alts) {
+    if (alt.empty()) {
+      continue;
     }
-    format_icons = format_icons[_alt];
-  }
-  if (format_icons.isArray()) {
-    auto size = format_icons.size();
-    if (size != 0U) {
-      auto idx = std::clamp(percentage / ((max == 0 ? 100 : max) / size), 0U, size - 1);
-      format_icons = format_icons[idx];
+    auto it = icons_.find(alt);
+    if (it != icons_.end()) {
+      return pickIcon(it->second, percentage, max);
     }
   }
-  if (format_icons.isString()) {
-    return format_icons.asString();
+  return pickIcon(default_icons_, percentage, max);
+}
+
+const util::FormatTemplate& ALabel::formatTemplate(const std::string& format,
+                                                  const util::FormatTemplate::Binder& bind) {
+  auto it = format_templates_.find(format);
+  if (it == format_templates_.end()) {
+    it = format_templates_.emplace(format, util::FormatTemplate(format, bind)).first;
   }
-  return "";
+  return it->second;
 }
 
 bool waybar::ALabel::handleToggle(GdkEventButton* const& e) {
@@ -191,30 +310,34 @@ void ALabel::handleGtkMenuEvent(GtkMenuItem* /*menuitem*/, gpointer data) {
 }
 
 std::string ALabel::getState(uint8_t value, bool lesser) {
-  if (!config_["states"].isObject()) {
+  if (states_.empty()) {
     return "";
   }
-  // Get current state
-  std::vector<std::pair<std::string, uint8_t>> states;
-  if (config_["states"].isObject()) {
-    for (auto it = config_["states"].begin(); it != config_["states"].end(); ++it) {
-      if (it->isUInt() && it.key().isString()) {
-        states.emplace_back(it.key().asString(), it->asUInt());
-      }
+  // The first crossed threshold, from the highest one (or the lowest one for lesser states)
+  auto crossed = [value, lesser](const auto& state) {
+    return lesser ? value <= state.second : value >= state.second;
+  };
+  std::string valid_state;
+  if (lesser) {
+    auto it = std::find_if(states_.rbegin(), states_.rend(), crossed);
+    if (it != states_.rend()) {
+      valid_state = it->first;
+    }
+  } else {
+    auto it = std::ranges::find_if(states_, crossed);
+    if (it != states_.end()) {
+      valid_state = it->first;
     }
   }
-  // Sort states
-  std::ranges::sort(states.begin(), states.end(), [&lesser](auto& a, auto& b) {
-    return lesser ? a.second < b.second : a.second > b.second;
-  });
-  std::string valid_state;
-  for (auto const& state : states) {
-    if ((lesser ? value <= state.second : value >= state.second) && valid_state.empty()) {
-      label_.get_style_context()->add_class(state.first);
-      valid_state = state.first;
-    } else {
-      label_.get_style_context()->remove_class(state.first);
+  // Only touch the style context when the state transitions
+  if (valid_state != state_class_) {
+    if (!state_class_.empty()) {
+      label_.remove_class(state_class_);
+    }
+    if (!valid_state.empty()) {
+      label_.add_class(valid_state);
     }
+    state_class_ = valid_state;
   }
   return valid_state;
 }
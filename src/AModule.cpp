@@ -3,6 +3,8 @@
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+
 #include <util/command.hpp>
 
 #include "gdk/gdk.h"
@@ -16,6 +18,8 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
       config_(config),
       isTooltip{config_["tooltip"].isBool() ? config_["tooltip"].asBool() : true},
       isExpand{config_["expand"].isBool() ? config_["expand"].asBool() : false},
+      stats_{util::Telemetry::current() ? util::Telemetry::current()
+                                        : util::Telemetry::inst().create(name, "")},
       distance_scrolled_y_(0.0),
       distance_scrolled_x_(0.0) {
   // Configure module action Map
@@ -167,6 +171,7 @@ bool AModule::handleRelease(GdkEventButton* const& e) { return handleUserEvent(e
  * @return `true` always (the event is handled).
  */
 bool AModule::handleUserEvent(GdkEventButton* const& e) {
+  util::Telemetry::Scope scope(stats_);
   std::string format{};
   const std::map<std::pair<uint, GdkEventType>, std::string>::const_iterator& rec{
       eventMap_.find(std::pair(e->button, e->type))};
@@ -280,14 +285,34 @@ bool AModule::handleScroll(GdkEventScroll* e) {
   else if (dir == SCROLL_DIR::RIGHT)
     eventName = "on-scroll-right";
 
+  this->AModule::triggerEvent(eventName);
+  return true;
+}
+
+bool AModule::isUserEvent(const std::string& event) {
+  if (event == "on-scroll-up" || event == "on-scroll-down" || event == "on-scroll-left" ||
+      event == "on-scroll-right") {
+    return true;
+  }
+  return std::ranges::any_of(eventMap_,
+                             [&event](const auto& entry) { return entry.second == event; });
+}
+
+void AModule::triggerEvent(const std::string& event) {
+  util::Telemetry::Scope scope(stats_);
   // First call module actions
-  this->AModule::doAction(eventName);
+  this->AModule::doAction(event);
   // Second call user scripts
-  if (config_[eventName].isString())
-    pid_children_.push_back(util::command::forkExec(config_[eventName].asString()));
+  if (config_[event].isString())
+    pid_children_.push_back(util::command::forkExec(config_[event].asString()));
 
   dp.emit();
-  return true;
+}
+
+Json::Value AModule::state() const {
+  Json::Value state(Json::objectValue);
+  state["visible"] = event_box_.get_visible();
+  return state;
 }
 
 bool AModule::tooltipEnabled() const { return isTooltip; }
@@ -13,6 +13,7 @@
 #include "group.hpp"
 #include "util/enum.hpp"
 #include "util/kill_signal.hpp"
+#include "util/telemetry.hpp"
 
 #ifdef HAVE_SWAY
 #include "modules/sway/bar.hpp"
@@ -531,6 +532,18 @@ void waybar::Bar::handleSignal(int signal) {
   }
 }
 
+std::vector<std::shared_ptr<waybar::AModule>> waybar::Bar::findModules(
+    const std::string& ref) const {
+  std::vector<std::shared_ptr<AModule>> modules;
+  for (const auto& module : modules_all_) {
+    // Stats are named after the reference the module was created from
+    if (ref.empty() || (module->stats() && module->stats()->name == ref)) {
+      modules.push_back(module);
+    }
+  }
+  return modules;
+}
+
 waybar::util::KillSignalAction waybar::Bar::getOnSigusr1Action() { return this->onSigusr1; }
 waybar::util::KillSignalAction waybar::Bar::getOnSigusr2Action() { return this->onSigusr2; }
 
@@ -541,6 +554,8 @@ void waybar::Bar::getModules(const Factory& factory, const std::string& pos,
     for (const auto& name : module_list) {
       try {
         auto ref = name.asString();
+        // Modules (and the threads they start) record their cost in these stats
+        util::Telemetry::Scope scope(util::Telemetry::inst().create(ref, output->name));
         AModule* module;
 
         if (ref.compare(0, 6, "group/") == 0 && ref.size() > 6) {
@@ -578,11 +593,18 @@ void waybar::Bar::getModules(const Factory& factory, const std::string& pos,
           }
         }
         module->dp.connect([module, ref] {
+          const auto& stats = module->stats();
+          util::Telemetry::Scope scope(stats);
+          if (auto latency = module->dp.takeLatency(); latency.count() > 0) {
+            stats->dispatch_latency.record(latency);
+          }
+          auto start = std::chrono::steady_clock::now();
           try {
             module->update();
           } catch (const std::exception& e) {
             spdlog::error("{}: {}", ref, e.what());
           }
+          stats->update.record(std::chrono::steady_clock::now() - start);
         });
       } catch (const std::exception& e) {
         spdlog::warn("module {}: {}", name.asString(), e.what());
@@ -8,8 +8,11 @@
 
 #include "gtkmm/icontheme.h"
 #include "idle-inhibit-unstable-v1-client-protocol.h"
+#include "modules/custom.hpp"
 #include "util/clara.hpp"
 #include "util/format.hpp"
+#include "util/scheduler.hpp"
+#include "util/spawn.hpp"
 
 waybar::Client *waybar::Client::inst() {
   static auto *c = new Client();
@@ -234,7 +237,10 @@ int waybar::Client::main(int argc, char *argv[]) {
              clara::detail::Opt(
                  log_level,
                  "trace|debug|info|warning|error|critical|off")["-l"]["--log-level"]("Log level") |
-             clara::detail::Opt(bar_id, "id")["-b"]["--bar"]("Bar id");
+             clara::detail::Opt(bar_id, "id")["-b"]["--bar"]("Bar id") |
+             clara::detail::Opt(stats_path, "file")["--stats"](
+                 "Write module stats as JSON to file on SIGRTMIN") |
+             clara::detail::Opt(socket_path, "path|none")["--socket"]("Control socket path");
   auto res = cli.parse(clara::detail::Args(argc, argv));
   if (!res) {
     spdlog::error("Error in command line: {}", res.errorMessage());
@@ -290,14 +296,131 @@ int waybar::Client::main(int argc, char *argv[]) {
     }
   }
 
+  // Interval modules of every bar share one scheduler, use the largest slack requested
+  auto timer_slack = std::chrono::milliseconds(0);
+  // Commands are spawned the same way for every bar, run them directly if any bar asks to
+  bool direct_exec = false;
+  auto read_global = [&timer_slack, &direct_exec](const Json::Value &conf) {
+    if (conf["timer-slack"].isUInt()) {
+      timer_slack = std::max(timer_slack, std::chrono::milliseconds(conf["timer-slack"].asUInt()));
+    }
+    direct_exec = direct_exec || (conf["direct-exec"].isBool() && conf["direct-exec"].asBool());
+  };
+  if (m_config.isObject()) {
+    read_global(m_config);
+  } else if (m_config.isArray()) {
+    for (const auto &conf : m_config) {
+      read_global(conf);
+    }
+  }
+  util::Scheduler::inst().setSlack(timer_slack);
+  util::setDirectExec(direct_exec);
+
   bindInterfaces();
+  setupControlSocket();
   gtk_app->hold();
   gtk_app->run();
   m_cssReloadHelper.reset();  // stop watching css file
+  control_socket_.reset();
+  pushed_.clear();
   bars.clear();
   return 0;
 }
 
+void waybar::Client::setupControlSocket() {
+  auto path = socket_path.empty() ? util::ControlSocket::defaultPath() : socket_path;
+  if (path.empty() || path == "none") {
+    return;
+  }
+  try {
+    control_socket_ = std::make_unique<util::ControlSocket>(
+        path, [this](const auto &request) { return handleRequest(request); },
+        [this] {
+          for (const auto &module : pushed_) {
+            module->dp.emit();
+          }
+          pushed_.clear();
+        });
+    spdlog::debug("Control socket listening on {}", path);
+  } catch (const std::exception &e) {
+    spdlog::warn("{}", e.what());
+  }
+}
+
+/**
+ * Handle a request of the control socket:
+ *   list                              modules of every bar
+ *   get <module>[@<output>]           what the module shows
+ *   push <module>[@<output>] <record> show a record on a custom module, without running its exec
+ *   action <module>[@<output>] <event> act as if the user clicked or scrolled, e.g. on-click
+ */
+std::string waybar::Client::handleRequest(const util::ControlSocket::Request &request) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  if (request.command == "list") {
+    Json::Value list(Json::arrayValue);
+    for (const auto &bar : bars) {
+      for (const auto &module : bar->findModules("")) {
+        Json::Value entry(Json::objectValue);
+        entry["module"] = module->stats()->name;
+        entry["output"] = bar->output->name;
+        list.append(entry);
+      }
+    }
+    return Json::writeString(builder, list);
+  }
+
+  if (request.module.empty()) {
+    return "error missing module";
+  }
+  std::vector<std::shared_ptr<AModule>> modules;
+  std::vector<std::string> outputs;
+  for (const auto &bar : bars) {
+    if (!request.output.empty() && request.output != bar->output->name) {
+      continue;
+    }
+    for (auto &module : bar->findModules(request.module)) {
+      modules.push_back(std::move(module));
+      outputs.push_back(bar->output->name);
+    }
+  }
+  if (modules.empty()) {
+    return "error no module " + request.module;
+  }
+
+  if (request.command == "get") {
+    Json::Value states(Json::arrayValue);
+    for (size_t i = 0; i < modules.size(); i++) {
+      auto state = modules[i]->state();
+      state["module"] = request.module;
+      state["output"] = outputs[i];
+      states.append(state);
+    }
+    return Json::writeString(builder, states);
+  }
+  if (request.command == "push") {
+    for (const auto &module : modules) {
+      auto *custom = dynamic_cast<modules::Custom *>(module.get());
+      if (custom == nullptr || !custom->push(request.argument)) {
+        return "error " + request.module + " is not a custom module, or is shared";
+      }
+      pushed_.insert(module);
+    }
+    return "ok";
+  }
+  if (request.command == "action") {
+    // Any other key of the config could be a command, e.g. "exec"
+    if (!AModule::isUserEvent(request.argument)) {
+      return "error unknown event " + request.argument;
+    }
+    for (const auto &module : modules) {
+      module->triggerEvent(request.argument);
+    }
+    return "ok";
+  }
+  return "error unknown command " + request.command;
+}
+
 void waybar::Client::reset() {
   gtk_app->quit();
   // delete signal handler for css changes
@@ -10,6 +10,7 @@
 #include "bar.hpp"
 #include "client.hpp"
 #include "util/SafeSignal.hpp"
+#include "util/telemetry.hpp"
 
 std::mutex reap_mtx;
 std::list<pid_t> reap;
@@ -29,7 +30,7 @@ static void writeSignalToPipe(int signum) {
 // This initializes `signal_pipe_write_fd`, and sets up signal handlers.
 //
 // This function will run forever, emitting every `SIGUSR1`, `SIGUSR2`,
-// `SIGINT`, `SIGCHLD`, and `SIGRTMIN + 1`...`SIGRTMAX` signal received
+// `SIGINT`, `SIGCHLD`, and `SIGRTMIN`...`SIGRTMAX` signal received
 // to `signal_handler`.
 static void catchSignals(waybar::SafeSignal<int>& signal_handler) {
   int fd[2];
@@ -52,7 +53,7 @@ static void catchSignals(waybar::SafeSignal<int>& signal_handler) {
   std::signal(SIGINT, writeSignalToPipe);
   std::signal(SIGCHLD, writeSignalToPipe);
 
-  for (int sig = SIGRTMIN + 1; sig <= SIGRTMAX; ++sig) {
+  for (int sig = SIGRTMIN; sig <= SIGRTMAX; ++sig) {
     std::signal(sig, writeSignalToPipe);
   }
 
@@ -111,11 +112,31 @@ void handleUserSignal(int signal, bool& reload) {
   }
 }
 
+// Log the cost of every module, and write it to the `--stats` file if set.
+static void dumpStats() {
+  auto& telemetry = waybar::util::Telemetry::inst();
+  telemetry.log();
+  const auto& path = waybar::Client::inst()->stats_path;
+  if (path.empty()) {
+    return;
+  }
+  try {
+    telemetry.write(path);
+    spdlog::info("Module stats written to {}", path);
+  } catch (const std::exception& e) {
+    spdlog::error("Unable to write module stats: {}", e.what());
+  }
+}
+
 // Must be called on the main thread.
 //
 // If this signal should restart or close the bar, this function will write
 // `true` or `false`, respectively, into `reload`.
 static void handleSignalMainThread(int signum, bool& reload) {
+  if (signum == SIGRTMIN) {
+    dumpStats();
+    return;
+  }
   if (signum >= SIGRTMIN + 1 && signum <= SIGRTMAX) {
     for (auto& bar : waybar::Client::inst()->bars) {
       bar->handleSignal(signum);
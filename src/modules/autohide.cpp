@@ -1,7 +1,10 @@
 #include "modules/autohide.hpp"
 
+#include <glibmm/main.h>
+#include <gtk-layer-shell.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdio>
@@ -13,12 +16,13 @@ namespace waybar::modules {
 
 /**
  * @brief Initialize Autohide module: configure thresholds/delays, register IPC events, and start
- * mouse tracking.
+ * watching the pointer.
  *
  * Constructs an Autohide instance for the given bar using the provided configuration. Reads
  * threshold and timing options from `config` (falling back to sensible defaults), marks Hyprland
- * modules as ready for IPC, registers for `workspacev2` and `focusedmonv2` events, and launches the
- * background mouse-tracking thread that drives autohide behavior.
+ * modules as ready for IPC, and registers for `workspacev2` and `focusedmonv2` events. The pointer
+ * is watched through a hot-zone surface along the bar's edge, or, with `"hot-zone": false`, by a
+ * background thread polling the cursor position.
  *
  * @param id Module identifier.
  * @param bar Reference to the Bar this module controls.
@@ -29,7 +33,9 @@ Autohide::Autohide(const std::string& id, const Bar& bar, const Json::Value& con
       config_(config),
       bar_(const_cast<Bar*>(&bar)),
       m_ipc(waybar::modules::hyprland::IPC::inst()),
+      use_hot_zone_(!config["hot-zone"].isBool() || config["hot-zone"].asBool()),
       waybar_state_(WaybarState::VISIBLE),  // Start with waybar visible (as it is by default)
+      hot_zone_(Gtk::WINDOW_TOPLEVEL),
       mouse_thread_running_(false),
       mouse_thread_exit_(false) {
   // Set modulesReady flag - this is required for IPC to work
@@ -47,8 +53,9 @@ Autohide::Autohide(const std::string& id, const Bar& bar, const Json::Value& con
 
   spdlog::info(
       "Autohide module initialized - hidden_y: {}, visible_y: {}, delay_show: {}ms, delay_hide: "
-      "{}ms, interval: {}ms",
-      threshold_hidden_y_, threshold_visible_y_, delay_show_, delay_hide_, check_interval_);
+      "{}ms, interval: {}ms, hot_zone: {}",
+      threshold_hidden_y_, threshold_visible_y_, delay_show_, delay_hide_, check_interval_,
+      use_hot_zone_);
 
   // Register for workspace events - the IPC system will handle the registration
   // even if it's not ready yet (it will queue the registration)
@@ -58,8 +65,15 @@ Autohide::Autohide(const std::string& id, const Bar& bar, const Json::Value& con
 
   // dp.emit() will automatically call update() on the main thread
 
-  // Start mouse tracking thread
-  startMouseTracking();
+  if (use_hot_zone_ && !gtk_layer_is_supported()) {
+    spdlog::warn("Autohide: no layer shell in the compositor, polling the cursor position instead");
+    use_hot_zone_ = false;
+  }
+  if (use_hot_zone_) {
+    setupHotZone();
+  } else {
+    startMouseTracking();
+  }
 }
 
 /**
@@ -67,13 +81,220 @@ Autohide::Autohide(const std::string& id, const Bar& bar, const Json::Value& con
  * from IPC.
  *
  * Ensures the mouse-tracking thread is stopped before removing IPC callbacks to avoid races with
- * incoming events.
+ * incoming events. Disconnects the timers and the handlers on the bar's window, which outlives
+ * the module.
  */
 Autohide::~Autohide() {
+  pending_timer_.disconnect();
+  map_check_.disconnect();
+  bar_enter_.disconnect();
+  bar_leave_.disconnect();
   stopMouseTracking();
   m_ipc.unregisterForIPC(this);
 }
 
+/**
+ * @brief Create the hot zone: a transparent, keyboard-less layer surface along the bar's edge.
+ *
+ * The zone is `threshold-hidden-y` pixels thick (at least one) and sits on the overlay layer,
+ * ignoring other surfaces' exclusive zones so that it stays on the screen edge. Entering it shows
+ * the hidden bar; leaving both it and the bar hides the bar again. Nothing is polled: the
+ * compositor reports the crossings, and the show/hide delays run as main loop timeouts. While the
+ * bar is shown, the zone has an empty input region: clicks and scrolls on the screen edge go to
+ * the bar, or to the windows below, as without the zone.
+ *
+ * If the compositor doesn't configure the zone within a second, falls back to polling. GTK marks
+ * the window mapped on show() whatever the compositor does, only its configure event tells.
+ */
+void Autohide::setupHotZone() {
+  auto* gtk_window = hot_zone_.gobj();
+  gtk_layer_init_for_window(gtk_window);
+  gtk_layer_set_keyboard_mode(gtk_window, GTK_LAYER_SHELL_KEYBOARD_MODE_NONE);
+  gtk_layer_set_monitor(gtk_window, bar_->output->monitor->gobj());
+  gtk_layer_set_namespace(gtk_window, "waybar-autohide");
+  gtk_layer_set_layer(gtk_window, GTK_LAYER_SHELL_LAYER_OVERLAY);
+  gtk_layer_set_exclusive_zone(gtk_window, -1);
+
+  // Anchored to the bar's edge and stretched along it
+  auto edge = GTK_LAYER_SHELL_EDGE_TOP;
+  if (bar_->position == Gtk::POS_BOTTOM) {
+    edge = GTK_LAYER_SHELL_EDGE_BOTTOM;
+  } else if (bar_->position == Gtk::POS_LEFT) {
+    edge = GTK_LAYER_SHELL_EDGE_LEFT;
+  } else if (bar_->position == Gtk::POS_RIGHT) {
+    edge = GTK_LAYER_SHELL_EDGE_RIGHT;
+  }
+  const bool vertical = edge == GTK_LAYER_SHELL_EDGE_LEFT || edge == GTK_LAYER_SHELL_EDGE_RIGHT;
+  gtk_layer_set_anchor(gtk_window, edge, TRUE);
+  gtk_layer_set_anchor(gtk_window, vertical ? GTK_LAYER_SHELL_EDGE_TOP : GTK_LAYER_SHELL_EDGE_LEFT,
+                       TRUE);
+  gtk_layer_set_anchor(gtk_window,
+                       vertical ? GTK_LAYER_SHELL_EDGE_BOTTOM : GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
+
+  const int thickness = std::max<int>(threshold_hidden_y_, 1);
+  if (vertical) {
+    hot_zone_.set_size_request(thickness, -1);
+  } else {
+    hot_zone_.set_size_request(-1, thickness);
+  }
+  hot_zone_.set_opacity(0);
+
+  hot_zone_.add_events(Gdk::ENTER_NOTIFY_MASK | Gdk::LEAVE_NOTIFY_MASK | Gdk::STRUCTURE_MASK);
+  hot_zone_.signal_configure_event().connect([this](GdkEventConfigure* /*event*/) {
+    hot_zone_configured_ = true;
+    return false;
+  });
+  hot_zone_.signal_enter_notify_event().connect(
+      sigc::mem_fun(*this, &Autohide::handleHotZoneCrossing));
+  hot_zone_.signal_leave_notify_event().connect(
+      sigc::mem_fun(*this, &Autohide::handleHotZoneCrossing));
+  bar_->window.add_events(Gdk::ENTER_NOTIFY_MASK | Gdk::LEAVE_NOTIFY_MASK);
+  bar_enter_ = bar_->window.signal_enter_notify_event().connect(
+      sigc::mem_fun(*this, &Autohide::handleBarCrossing));
+  bar_leave_ = bar_->window.signal_leave_notify_event().connect(
+      sigc::mem_fun(*this, &Autohide::handleBarCrossing));
+
+  hot_zone_.show();
+  // The bar starts visible
+  setHotZoneInput(false);
+
+  map_check_ = Glib::signal_timeout().connect_seconds(
+      [this] {
+        if (!hot_zone_configured_) {
+          fallBackToPolling();
+        }
+        return false;
+      },
+      1);
+
+  // Hides after `delay_hide_` unless the pointer comes to the bar, as the first poll would
+  schedule(WaybarState::PENDING_HIDDEN, delay_hide_);
+}
+
+/**
+ * @brief Drop the hot zone and poll the cursor position instead.
+ */
+void Autohide::fallBackToPolling() {
+  spdlog::warn(
+      "Autohide: hot zone surface was not configured, polling the cursor position instead");
+  use_hot_zone_ = false;
+  pending_timer_.disconnect();
+  bar_enter_.disconnect();
+  bar_leave_.disconnect();
+  hot_zone_.hide();
+  startMouseTracking();
+}
+
+/**
+ * @brief Let the hot zone receive pointer input, or pass it through to what is below it.
+ */
+void Autohide::setHotZoneInput(bool enabled) {
+  auto gdk_window = hot_zone_.get_window();
+  if (!gdk_window || hot_zone_input_ == enabled) {
+    return;
+  }
+  hot_zone_input_ = enabled;
+  Cairo::RefPtr<Cairo::Region> region;
+  if (!enabled) {
+    region = Cairo::Region::create();
+  }
+  gdk_window->input_shape_combine_region(region, 0, 0);
+  // The zone is never redrawn, which would commit the change
+  gtk_layer_try_force_commit(hot_zone_.gobj());
+}
+
+/**
+ * @brief Track the pointer entering or leaving the hot zone.
+ *
+ * @return false, so that the event propagates.
+ */
+bool Autohide::handleHotZoneCrossing(GdkEventCrossing* ev) {
+  pointer_in_hot_zone_ = ev->type == GDK_ENTER_NOTIFY;
+  onPointerCrossed();
+  return false;
+}
+
+/**
+ * @brief Track the pointer entering or leaving the bar, ignoring moves between its widgets.
+ *
+ * @return false, so that the bar's own handlers still run.
+ */
+bool Autohide::handleBarCrossing(GdkEventCrossing* ev) {
+  if (ev->detail == GDK_NOTIFY_INFERIOR) {
+    return false;
+  }
+  pointer_in_bar_ = ev->type == GDK_ENTER_NOTIFY;
+  onPointerCrossed();
+  return false;
+}
+
+/**
+ * @brief Drive the state machine from the pointer's position relative to the hot zone and bar.
+ *
+ * - Entering the hot zone while hidden schedules a show after `delay_show_`; leaving it before
+ *   then cancels the show.
+ * - Leaving both the hot zone and the bar while visible schedules a hide after `delay_hide_`;
+ *   coming back to either cancels the hide.
+ *
+ * Runs on the main thread.
+ */
+void Autohide::onPointerCrossed() {
+  const bool inside = pointer_in_hot_zone_ || pointer_in_bar_;
+  switch (waybar_state_.load()) {
+    case WaybarState::HIDDEN:
+      if (pointer_in_hot_zone_) {
+        spdlog::debug("Autohide: Pointer entered the hot zone - scheduling show");
+        schedule(WaybarState::PENDING_VISIBLE, delay_show_);
+      }
+      break;
+    case WaybarState::PENDING_VISIBLE:
+      if (!pointer_in_hot_zone_) {
+        spdlog::debug("Autohide: Pointer left the hot zone - canceling show");
+        pending_timer_.disconnect();
+        waybar_state_ = WaybarState::HIDDEN;
+      }
+      break;
+    case WaybarState::VISIBLE:
+      if (!inside) {
+        spdlog::trace("Autohide: Pointer left the bar - scheduling hide");
+        schedule(WaybarState::PENDING_HIDDEN, delay_hide_);
+      }
+      break;
+    case WaybarState::PENDING_HIDDEN:
+      if (inside) {
+        spdlog::trace("Autohide: Pointer back on the bar - canceling hide");
+        pending_timer_.disconnect();
+        waybar_state_ = WaybarState::VISIBLE;
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Enter the pending state `pending` and complete it after `delay` milliseconds.
+ *
+ * Replaces any pending transition. Uses a minimum 10 ms delay, as the polling path does. If the
+ * state changed in the meantime, e.g. a workspace event forced the bar visible, the timeout does
+ * nothing.
+ */
+void Autohide::schedule(WaybarState pending, uint32_t delay) {
+  waybar_state_ = pending;
+  pending_timer_.disconnect();
+  pending_timer_ = Glib::signal_timeout().connect(
+      [this, pending] {
+        auto expected = pending;
+        auto done =
+            pending == WaybarState::PENDING_VISIBLE ? WaybarState::VISIBLE : WaybarState::HIDDEN;
+        if (waybar_state_.compare_exchange_strong(expected, done)) {
+          spdlog::debug("Autohide: Executing delayed {}",
+                        done == WaybarState::VISIBLE ? "show" : "hide");
+          dp.emit();
+        }
+        return false;
+      },
+      std::max(delay, 10u));
+}
+
 /**
  * @brief Start background mouse-tracking for autohide behavior.
  *
@@ -289,7 +510,9 @@ bool Autohide::getMousePosition(int& x, int& y) {
  * @brief Apply the current autohide state to the associated bar's visibility.
  *
  * Sets the bar's mode to Bar::MODE_DEFAULT when the state is VISIBLE or PENDING_HIDDEN,
- * and to Bar::MODE_INVISIBLE when the state is HIDDEN or PENDING_VISIBLE.
+ * and to Bar::MODE_INVISIBLE when the state is HIDDEN or PENDING_VISIBLE. With the hot zone, a bar
+ * made visible while the pointer is away from it, e.g. by a workspace event, is scheduled to hide,
+ * and the hot zone only takes input while the bar is hidden.
  *
  * @note This method runs on the main thread and is safe to perform GTK operations.
  */
@@ -300,7 +523,17 @@ void Autohide::update() {
     return;
   }
 
-  switch (waybar_state_.load()) {
+  if (use_hot_zone_ && waybar_state_ == WaybarState::VISIBLE && !pointer_in_hot_zone_ &&
+      !pointer_in_bar_) {
+    schedule(WaybarState::PENDING_HIDDEN, delay_hide_);
+  }
+
+  const auto state = waybar_state_.load();
+  if (use_hot_zone_) {
+    setHotZoneInput(state == WaybarState::HIDDEN || state == WaybarState::PENDING_VISIBLE);
+  }
+
+  switch (state) {
     case WaybarState::VISIBLE:
     case WaybarState::PENDING_HIDDEN:
       bar_->setMode(Bar::MODE_DEFAULT);
@@ -715,9 +715,9 @@ auto waybar::modules::Battery::update() -> void {
                     fmt::arg("health", fmt::format("{:.3}", health))));
   }
   if (!old_status_.empty()) {
-    label_.get_style_context()->remove_class(old_status_);
+    label_.remove_class(old_status_);
   }
-  label_.get_style_context()->add_class(status);
+  label_.add_class(status);
   old_status_ = status;
   if (!state.empty() && config_["format-" + status + "-" + state].isString()) {
     format = config_["format-" + status + "-" + state].asString();
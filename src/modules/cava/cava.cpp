@@ -25,8 +25,8 @@ auto waybar::modules::cava::Cava::doAction(const std::string& name) -> void {
 void waybar::modules::cava::Cava::pause_resume() { backend_->doPauseResume(); }
 auto waybar::modules::cava::Cava::onUpdate(const std::string& input) -> void {
   if (silence_) {
-    label_.get_style_context()->remove_class("silent");
-    label_.get_style_context()->add_class("updated");
+    label_.remove_class("silent");
+    label_.add_class("updated");
   }
   label_text_.clear();
   for (auto& ch : input)
@@ -39,13 +39,13 @@ auto waybar::modules::cava::Cava::onUpdate(const std::string& input) -> void {
 }
 auto waybar::modules::cava::Cava::onSilence() -> void {
   if (!silence_) {
-    label_.get_style_context()->remove_class("updated");
+    label_.remove_class("updated");
 
     if (hide_on_silence_)
       label_.hide();
     else if (config_["format_silent"].isString())
       label_.set_markup(format_silent_);
     silence_ = true;
-    label_.get_style_context()->add_class("silent");
+    label_.add_class("silent");
   }
 }
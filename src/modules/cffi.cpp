@@ -1,16 +1,19 @@
 #include "modules/cffi.hpp"
 
 #include <dlfcn.h>
+#include <fmt/format.h>
 #include <json/value.h>
+#include <spdlog/spdlog.h>
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include <type_traits>
 
 namespace waybar::modules {
 
 CFFI::CFFI(const std::string& name, const std::string& id, const Json::Value& config)
-    : AModule(config, name, id, true, true) {
+    : ALabel(config, name, id, "{text}", 0, false, true, true) {
   const auto dynlib_path = config_["module_path"].asString();
   if (dynlib_path.empty()) {
     throw std::runtime_error{"Missing or empty 'module_path' in module config"};
@@ -28,7 +31,7 @@ CFFI::CFFI(const std::string& name, const std::string& id, const Json::Value& co
   }
 
   // Fetch functions
-  if (*wbcffi_version == 1 || *wbcffi_version == 2) {
+  if (*wbcffi_version >= 1 && *wbcffi_version <= 3) {
     // Mandatory functions
     hooks_.init = reinterpret_cast<InitFn*>(dlsym(handle, "wbcffi_init"));
     if (!hooks_.init) {
@@ -51,6 +54,11 @@ CFFI::CFFI(const std::string& name, const std::string& id, const Json::Value& co
   } else {
     throw std::runtime_error{"Unknown wbcffi_version " + std::to_string(*wbcffi_version)};
   }
+  // Older libraries fill the event box themselves
+  widgets_ = *wbcffi_version < 3;
+  if (widgets_) {
+    event_box_.remove();
+  }
 
   // Prepare init() arguments
   // Convert JSON values to string
@@ -80,9 +88,14 @@ CFFI::CFFI(const std::string& name, const std::string& id, const Json::Value& co
       .waybar_version = VERSION,
       .get_root_widget =
           [](ffi::wbcffi_module* obj) {
-            return dynamic_cast<Gtk::Container*>(&((CFFI*)obj)->event_box_)->gobj();
+            auto* cffi = (CFFI*)obj;
+            // The label fills the event box of libraries publishing records
+            return cffi->widgets_ ? dynamic_cast<Gtk::Container*>(&cffi->event_box_)->gobj()
+                                  : nullptr;
           },
       .queue_update = [](ffi::wbcffi_module* obj) { ((CFFI*)obj)->dp.emit(); },
+      .publish = [](ffi::wbcffi_module* obj,
+                    const ffi::wbcffi_record* record) { ((CFFI*)obj)->publish(*record); },
   };
 
   // Call init
@@ -92,20 +105,85 @@ CFFI::CFFI(const std::string& name, const std::string& id, const Json::Value& co
   if (cffi_instance_ == nullptr) {
     throw std::runtime_error{"Failed to initialize C ABI module"};
   }
+  // Hidden until the first record is published
+  if (!widgets_) {
+    dp.emit();
+  }
 }
 
 CFFI::~CFFI() {
   if (cffi_instance_ != nullptr) {
+    // Stops the threads of the library, nothing is published after
     hooks_.deinit(cffi_instance_);
   }
+  delete pending_.exchange(nullptr);
+}
+
+void CFFI::publish(const ffi::wbcffi_record& record) {
+  auto copy = [](const char* str) { return str != nullptr ? std::string(str) : std::string(); };
+  auto* published = new Record{copy(record.text), copy(record.alt), copy(record.tooltip), {},
+                               record.percentage};
+  for (size_t i = 0; i < record.classes_len; i++) {
+    published->classes.push_back(copy(record.classes[i]));
+  }
+  // Only the latest record is shown, an update is already queued for the one replaced
+  if (auto* replaced = pending_.exchange(published, std::memory_order_acq_rel)) {
+    delete replaced;
+    stats()->dropped++;
+  } else {
+    dp.emit();
+  }
+}
+
+void CFFI::render() {
+  if (record_.text.empty()) {
+    event_box_.hide();
+    return;
+  }
+  auto percentage = std::clamp(record_.percentage, 0, 100);
+  auto icon = getIcon(percentage, record_.alt);
+  try {
+    label_.set_markup(fmt::format(fmt::runtime(format_), fmt::arg("text", record_.text),
+                                  fmt::arg("alt", record_.alt), fmt::arg("icon", icon),
+                                  fmt::arg("percentage", percentage)));
+    if (tooltipEnabled()) {
+      if (config_["tooltip-format"].isString()) {
+        label_.set_tooltip_markup(fmt::format(
+            fmt::runtime(config_["tooltip-format"].asString()), fmt::arg("text", record_.text),
+            fmt::arg("alt", record_.alt), fmt::arg("icon", icon),
+            fmt::arg("percentage", percentage)));
+      } else {
+        label_.set_tooltip_markup(record_.tooltip);
+      }
+    }
+  } catch (const fmt::format_error& e) {
+    spdlog::error("cffi/{}: {}", name_, e.what());
+  }
+  for (const auto& name : record_.classes) {
+    label_.add_class(name);
+  }
+  getState(percentage);
+  event_box_.show();
 }
 
 auto CFFI::update() -> void {
   assert(cffi_instance_ != nullptr);
   hooks_.update(cffi_instance_);
+  if (!widgets_) {
+    if (std::unique_ptr<Record> record{pending_.exchange(nullptr, std::memory_order_acq_rel)}) {
+      for (const auto& name : record_.classes) {
+        if (std::ranges::find(record->classes, name) == record->classes.end()) {
+          label_.remove_class(name);
+        }
+      }
+      record_ = std::move(*record);
+    }
+    // Also after a format-alt toggle
+    render();
+  }
 
   // Execute the on-update command set in config
-  AModule::update();
+  ALabel::update();
 }
 
 auto CFFI::refresh(int signal) -> void {
@@ -146,10 +146,8 @@ waybar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
     label_.signal_query_tooltip().connect(sigc::mem_fun(*this, &Clock::query_tlp_cb));
   }
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_ - system_clock::now().time_since_epoch() % interval_);
-  };
+  // The scheduler aligns ticks to multiples of the interval, so updates land on the boundary
+  timer_ = util::Scheduler::inst().schedule(interval_, [this] { dp.emit(); });
 }
 
 bool waybar::modules::Clock::query_tlp_cb(int, int, bool,
@@ -1,31 +1,56 @@
 #include "modules/cpu.hpp"
 
-#include "modules/cpu_frequency.hpp"
-#include "modules/cpu_usage.hpp"
 #include "modules/load.hpp"
 
-// In the 80000 version of fmt library authors decided to optimize imports
-// and moved declarations required for fmt::dynamic_format_arg_store in new
-// header fmt/args.h
-#if (FMT_VERSION >= 80000)
-#include <fmt/args.h>
-#else
-#include <fmt/core.h>
-#endif
-
 waybar::modules::Cpu::Cpu(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  // Sampling happens on the system sampler's worker, once for every bar
+  util::SystemSampler::Request request;
+  request.fields = util::SystemSampler::STAT | util::SystemSampler::LOADAVG;
+  request.read_stat = &CpuUsage::parseCpuinfo;
+  sampler_ = util::SystemSampler::inst().subscribe(interval_, std::move(request), &dp);
+  frequency_provider_ = util::SampledProvider<CpuFrequency::Sample>::get(
+      "cpu_frequency", interval_, &CpuFrequency::getCpuFrequency);
+  frequency_provider_->attach(dp);
+}
+
+int waybar::modules::Cpu::bindField(std::string_view name, size_t& index) {
+  if (name == "load") return LOAD;
+  if (name == "max_frequency") return MAX_FREQUENCY;
+  if (name == "min_frequency") return MIN_FREQUENCY;
+  if (name == "avg_frequency") return AVG_FREQUENCY;
+  return CpuUsage::bindField(name, index);
+}
+
+waybar::modules::Cpu::~Cpu() {
+  frequency_provider_->detach(dp);
+  sampler_.reset();
 }
 
 auto waybar::modules::Cpu::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [load1, load5, load15] = Load::getLoad();
-  auto [cpu_usage, tooltip] = CpuUsage::getCpuUsage(prev_times_);
-  auto [max_frequency, min_frequency, avg_frequency] = CpuFrequency::getCpuFrequency();
+  auto snapshot = sampler_.snapshot();
+  auto frequency = frequency_provider_->snapshot();
+  if (!snapshot || !frequency) {
+    return;
+  }
+  constexpr uint32_t fields = util::SystemSampler::STAT | util::SystemSampler::LOADAVG;
+  if (prev_ && !snapshot->changedSince(fields, prev_->version) && frequency == frequency_ &&
+      format_ == rendered_format_) {
+    // Nothing changed since the last render
+    return;
+  }
+  if (!prev_ || snapshot->changedSince(util::SystemSampler::STAT, prev_->version)) {
+    static const util::CpuTimes since_boot;
+    usage_ = CpuUsage::getCpuUsage(prev_ ? prev_->stat : since_boot, snapshot->stat);
+  }
+  prev_ = snapshot;
+  frequency_ = frequency;
+  rendered_format_ = format_;
+
+  auto [load1, load5, load15] =
+      Load::getLoad(snapshot->loadavg.value_or(std::array<double, 3>{}));
+  const auto& [cpu_usage, tooltip] = usage_;
+  auto [max_frequency, min_frequency, avg_frequency] = *frequency;
   if (tooltipEnabled()) {
     label_.set_tooltip_text(tooltip);
   }
@@ -41,21 +66,44 @@ auto waybar::modules::Cpu::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
-    fmt::dynamic_format_arg_store<fmt::format_context> store;
-    store.push_back(fmt::arg("load", load1));
-    store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
-    store.push_back(fmt::arg("max_frequency", max_frequency));
-    store.push_back(fmt::arg("min_frequency", min_frequency));
-    store.push_back(fmt::arg("avg_frequency", avg_frequency));
-    for (size_t i = 1; i < cpu_usage.size(); ++i) {
-      auto core_i = i - 1;
-      auto core_format = fmt::format("usage{}", core_i);
-      store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
-      auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
-    }
-    label_.set_markup(fmt::vformat(format, store));
+    formatTemplate(format, &Cpu::bindField)
+        .render(markup_, [&](const util::FormatTemplate::Field& field, std::string& out) {
+          switch (field.slot) {
+            case LOAD:
+              field.append(out, load1);
+              break;
+            case MAX_FREQUENCY:
+              field.append(out, max_frequency);
+              break;
+            case MIN_FREQUENCY:
+              field.append(out, min_frequency);
+              break;
+            case AVG_FREQUENCY:
+              field.append(out, avg_frequency);
+              break;
+            case CpuUsage::USAGE:
+              field.append(out, total_usage);
+              break;
+            case CpuUsage::ICON:
+              field.append(out, getIcon(total_usage, icons));
+              break;
+            case CpuUsage::CORE_USAGE:
+            case CpuUsage::CORE_ICON:
+              // Only the cores that exist have a usage
+              if (field.index + 1 >= cpu_usage.size()) {
+                util::FormatTemplate::unknownField(field);
+              }
+              if (field.slot == CpuUsage::CORE_USAGE) {
+                field.append(out, cpu_usage[field.index + 1]);
+              } else {
+                field.append(out, getIcon(cpu_usage[field.index + 1], icons));
+              }
+              break;
+            default:
+              util::FormatTemplate::unknownField(field);
+          }
+        });
+    label_.set_markup(markup_);
   }
 
   // Call parent update
@@ -1,25 +1,23 @@
 #include "modules/cpu_frequency.hpp"
 
-// In the 80000 version of fmt library authors decided to optimize imports
-// and moved declarations required for fmt::dynamic_format_arg_store in new
-// header fmt/args.h
-#if (FMT_VERSION >= 80000)
-#include <fmt/args.h>
-#else
-#include <fmt/core.h>
-#endif
+#include <algorithm>
+#include <array>
 
 waybar::modules::CpuFrequency::CpuFrequency(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu_frequency", id, "{avg_frequency}", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  provider_ = util::SampledProvider<Sample>::get("cpu_frequency", interval_,
+                                                 &CpuFrequency::getCpuFrequency);
+  provider_->attach(dp);
 }
 
+waybar::modules::CpuFrequency::~CpuFrequency() { provider_->detach(dp); }
+
 auto waybar::modules::CpuFrequency::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [max_frequency, min_frequency, avg_frequency] = CpuFrequency::getCpuFrequency();
+  auto sample = provider_->snapshot();
+  if (!sample) {
+    return;
+  }
+  auto [max_frequency, min_frequency, avg_frequency] = *sample;
   if (tooltipEnabled()) {
     auto tooltip =
         fmt::format("Minimum frequency: {}\nAverage frequency: {}\nMaximum frequency: {}\n",
@@ -37,19 +35,32 @@ auto waybar::modules::CpuFrequency::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
-    fmt::dynamic_format_arg_store<fmt::format_context> store;
-    store.push_back(fmt::arg("icon", getIcon(avg_frequency, icons)));
-    store.push_back(fmt::arg("max_frequency", max_frequency));
-    store.push_back(fmt::arg("min_frequency", min_frequency));
-    store.push_back(fmt::arg("avg_frequency", avg_frequency));
-    label_.set_markup(fmt::vformat(format, store));
+    const std::array<float, 3> frequencies = {max_frequency, min_frequency, avg_frequency};
+    // Slot 0-2 is a frequency, 3 the icon
+    auto bind = [](std::string_view name, size_t&) -> int {
+      static constexpr std::array<std::string_view, 4> names = {"max_frequency", "min_frequency",
+                                                                "avg_frequency", "icon"};
+      auto it = std::ranges::find(names, name);
+      return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+    };
+    formatTemplate(format, bind)
+        .render(markup_, [&](const util::FormatTemplate::Field& field, std::string& out) {
+          if (field.slot < 0) {
+            util::FormatTemplate::unknownField(field);
+          } else if (field.slot < 3) {
+            field.append(out, frequencies[field.slot]);
+          } else {
+            field.append(out, getIcon(avg_frequency, icons));
+          }
+        });
+    label_.set_markup(markup_);
   }
 
   // Call parent update
   ALabel::update();
 }
 
-std::tuple<float, float, float> waybar::modules::CpuFrequency::getCpuFrequency() {
+waybar::modules::CpuFrequency::Sample waybar::modules::CpuFrequency::getCpuFrequency() {
   std::vector<float> frequencies = CpuFrequency::parseCpuFrequencies();
   if (frequencies.empty()) {
     return {0.f, 0.f, 0.f};
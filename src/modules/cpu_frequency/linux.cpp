@@ -1,14 +1,136 @@
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <array>
+#include <cctype>
+#include <charconv>
 #include <filesystem>
 
 #include "modules/cpu_frequency.hpp"
 
+namespace {
+
+/**
+ * Current frequency of every cpu from cpufreq's scaling_cur_freq.
+ *
+ * Reading /proc/cpuinfo makes the kernel sample APERF/MPERF on every core through an IPI, which
+ * is slow and noisy on large machines. The sysfs files are opened once and re-read with pread();
+ * they are only looked up again when the set of present or online cpus changes.
+ */
+class ScalingFrequencies {
+ public:
+  ScalingFrequencies()
+      : present_fd_(open("/sys/devices/system/cpu/present", O_RDONLY | O_CLOEXEC)),
+        online_fd_(open("/sys/devices/system/cpu/online", O_RDONLY | O_CLOEXEC)) {}
+
+  ~ScalingFrequencies() {
+    closeFiles();
+    for (int fd : {present_fd_, online_fd_}) {
+      if (fd != -1) {
+        close(fd);
+      }
+    }
+  }
+
+  ScalingFrequencies(const ScalingFrequencies&) = delete;
+  ScalingFrequencies& operator=(const ScalingFrequencies&) = delete;
+
+  // Fills `frequencies` in MHz, returns false if cpufreq is not available
+  bool read(std::vector<float>& frequencies) {
+    if (topologyChanged()) {
+      rescan();
+    }
+    for (int fd : fds_) {
+      auto value = readValue(fd);
+      if (value > 0) {
+        // scaling_cur_freq is in kHz
+        frequencies.push_back(value / 1000.0f);
+      }
+    }
+    return !fds_.empty();
+  }
+
+ private:
+  bool topologyChanged() {
+    std::array<char, 128> buffer;
+    std::string topology;
+    for (int fd : {present_fd_, online_fd_}) {
+      if (fd == -1) {
+        continue;
+      }
+      auto len = pread(fd, buffer.data(), buffer.size(), 0);
+      if (len > 0) {
+        topology.append(buffer.data(), len);
+      }
+    }
+    if (scanned_ && topology == topology_) {
+      return false;
+    }
+    topology_ = std::move(topology);
+    return true;
+  }
+
+  void rescan() {
+    closeFiles();
+    scanned_ = true;
+    const std::filesystem::path cpu_dir = "/sys/devices/system/cpu";
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(cpu_dir, ec)) {
+      auto name = entry.path().filename().string();
+      if (name.size() <= 3 || name.compare(0, 3, "cpu") != 0 ||
+          !std::isdigit(static_cast<unsigned char>(name[3]))) {
+        continue;
+      }
+      auto path = entry.path() / "cpufreq" / "scaling_cur_freq";
+      int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd != -1) {
+        fds_.push_back(fd);
+      }
+    }
+    spdlog::debug("cpu_frequency: tracking scaling_cur_freq of {} cpus", fds_.size());
+  }
+
+  void closeFiles() {
+    for (int fd : fds_) {
+      close(fd);
+    }
+    fds_.clear();
+  }
+
+  static long readValue(int fd) {
+    std::array<char, 32> buffer;
+    auto len = pread(fd, buffer.data(), buffer.size(), 0);
+    long value = 0;
+    if (len > 0) {
+      std::from_chars(buffer.data(), buffer.data() + len, value);
+    }
+    return value;
+  }
+
+  int present_fd_;
+  int online_fd_;
+  bool scanned_ = false;
+  std::string topology_;
+  std::vector<int> fds_;
+};
+
+}  // namespace
+
 std::vector<float> waybar::modules::CpuFrequency::parseCpuFrequencies() {
+  std::vector<float> frequencies;
+  // Each provider samples on its own worker, keep one set of files per thread
+  thread_local ScalingFrequencies scaling_frequencies;
+  if (scaling_frequencies.read(frequencies)) {
+    return frequencies;
+  }
+
+  // Fall back to /proc/cpuinfo when cpufreq is not available
   const std::string file_path_ = "/proc/cpuinfo";
   std::ifstream info(file_path_);
   if (!info.is_open()) {
     throw std::runtime_error("Can't open " + file_path_);
   }
-  std::vector<float> frequencies;
   std::string line;
   while (getline(info, line)) {
     if (line.substr(0, 7).compare("cpu MHz") != 0) {
@@ -1,25 +1,34 @@
 #include "modules/cpu_usage.hpp"
 
-// In the 80000 version of fmt library authors decided to optimize imports
-// and moved declarations required for fmt::dynamic_format_arg_store in new
-// header fmt/args.h
-#if (FMT_VERSION >= 80000)
-#include <fmt/args.h>
-#else
-#include <fmt/core.h>
-#endif
+#include <charconv>
+#include <iterator>
 
 waybar::modules::CpuUsage::CpuUsage(const std::string& id, const Json::Value& config)
     : ALabel(config, "cpu_usage", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  // /proc/stat is sampled on the system sampler's worker, once for every bar
+  util::SystemSampler::Request request;
+  request.fields = util::SystemSampler::STAT;
+  request.read_stat = &CpuUsage::parseCpuinfo;
+  sampler_ = util::SystemSampler::inst().subscribe(interval_, std::move(request), &dp);
 }
 
+waybar::modules::CpuUsage::~CpuUsage() { sampler_.reset(); }
+
 auto waybar::modules::CpuUsage::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [cpu_usage, tooltip] = CpuUsage::getCpuUsage(prev_times_);
+  auto snapshot = sampler_.snapshot();
+  if (!snapshot) {
+    return;
+  }
+  if (!prev_ || snapshot->changedSince(util::SystemSampler::STAT, prev_->version)) {
+    static const util::CpuTimes since_boot;
+    usage_ = getCpuUsage(prev_ ? prev_->stat : since_boot, snapshot->stat);
+    prev_ = snapshot;
+  } else if (format_ == rendered_format_) {
+    // Neither the counters nor the format (format-alt) changed since the last render
+    return;
+  }
+  rendered_format_ = format_;
+  const auto& [cpu_usage, tooltip] = usage_;
   if (tooltipEnabled()) {
     label_.set_tooltip_text(tooltip);
   }
@@ -35,72 +44,97 @@ auto waybar::modules::CpuUsage::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
-    fmt::dynamic_format_arg_store<fmt::format_context> store;
-    store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
-    for (size_t i = 1; i < cpu_usage.size(); ++i) {
-      auto core_i = i - 1;
-      auto core_format = fmt::format("usage{}", core_i);
-      store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
-      auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
-    }
-    label_.set_markup(fmt::vformat(format, store));
+    formatTemplate(format, &CpuUsage::bindField)
+        .render(markup_, [&](const util::FormatTemplate::Field& field, std::string& out) {
+          switch (field.slot) {
+            case USAGE:
+              field.append(out, total_usage);
+              break;
+            case ICON:
+              field.append(out, getIcon(total_usage, icons));
+              break;
+            case CORE_USAGE:
+            case CORE_ICON:
+              // Only the cores that exist have a usage
+              if (field.index + 1 >= cpu_usage.size()) {
+                util::FormatTemplate::unknownField(field);
+              }
+              if (field.slot == CORE_USAGE) {
+                field.append(out, cpu_usage[field.index + 1]);
+              } else {
+                field.append(out, getIcon(cpu_usage[field.index + 1], icons));
+              }
+              break;
+            default:
+              util::FormatTemplate::unknownField(field);
+          }
+        });
+    label_.set_markup(markup_);
   }
 
   // Call parent update
   ALabel::update();
 }
 
-std::tuple<std::vector<uint16_t>, std::string> waybar::modules::CpuUsage::getCpuUsage(
-    std::vector<std::tuple<size_t, size_t>>& prev_times) {
-  if (prev_times.empty()) {
-    prev_times = CpuUsage::parseCpuinfo();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-  }
-  std::vector<std::tuple<size_t, size_t>> curr_times = CpuUsage::parseCpuinfo();
+int waybar::modules::CpuUsage::bindField(std::string_view name, size_t& index) {
+  auto core = [&name, &index](std::string_view prefix) {
+    if (!name.starts_with(prefix) || name.size() == prefix.size()) {
+      return false;
+    }
+    auto digits = name.substr(prefix.size());
+    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), index);
+    return ec == std::errc() && ptr == digits.data() + digits.size();
+  };
+  if (name == "usage") return USAGE;
+  if (name == "icon") return ICON;
+  if (core("usage")) return CORE_USAGE;
+  if (core("icon")) return CORE_ICON;
+  return -1;
+}
+
+waybar::modules::CpuUsage::Sample waybar::modules::CpuUsage::getCpuUsage(
+    const util::CpuTimes& prev_times, const util::CpuTimes& curr_times) {
+  // Without a previous sample, report the average since boot
+  const bool first_sample = prev_times.size() == 0;
+  auto percent = [&](size_t i) -> uint16_t {
+    const float delta_idle = curr_times.idle[i] - (first_sample ? 0 : prev_times.idle[i]);
+    const float delta_total = curr_times.total[i] - (first_sample ? 0 : prev_times.total[i]);
+    return delta_total > 0 ? 100 * (1 - delta_idle / delta_total) : 0;
+  };
   std::string tooltip;
   std::vector<uint16_t> usage;
 
-  if (curr_times.size() != prev_times.size()) {
+  if (curr_times.size() == 0 || (!first_sample && curr_times.size() != prev_times.size())) {
     // The number of CPUs has changed, eg. due to CPU hotplug
     // We don't know which CPU came up or went down
     // so only give total usage (if we can)
-    if (!curr_times.empty() && !prev_times.empty()) {
-      auto [curr_idle, curr_total] = curr_times[0];
-      auto [prev_idle, prev_total] = prev_times[0];
-      const float delta_idle = curr_idle - prev_idle;
-      const float delta_total = curr_total - prev_total;
-      uint16_t tmp = 100 * (1 - delta_idle / delta_total);
+    if (curr_times.size() != 0) {
+      uint16_t tmp = percent(0);
       tooltip = fmt::format("Total: {}%\nCores: (pending)", tmp);
       usage.push_back(tmp);
     } else {
       tooltip = "(pending)";
       usage.push_back(0);
     }
-    prev_times = curr_times;
     return {usage, tooltip};
   }
 
+  usage.reserve(curr_times.size());
+  auto out = std::back_inserter(tooltip);
   for (size_t i = 0; i < curr_times.size(); ++i) {
-    auto [curr_idle, curr_total] = curr_times[i];
-    auto [prev_idle, prev_total] = prev_times[i];
-    if (i > 0 && (curr_total == 0 || prev_total == 0)) {
+    if (i > 0 && (curr_times.total[i] == 0 || (!first_sample && prev_times.total[i] == 0))) {
       // This CPU is offline
-      tooltip = tooltip + fmt::format("\nCore{}: offline", i - 1);
+      fmt::format_to(out, "\nCore{}: offline", i - 1);
       usage.push_back(0);
       continue;
     }
-    const float delta_idle = curr_idle - prev_idle;
-    const float delta_total = curr_total - prev_total;
-    uint16_t tmp = 100 * (1 - delta_idle / delta_total);
+    uint16_t tmp = percent(i);
     if (i == 0) {
-      tooltip = fmt::format("Total: {}%", tmp);
+      fmt::format_to(out, "Total: {}%", tmp);
     } else {
-      tooltip = tooltip + fmt::format("\nCore{}: {}%", i - 1, tmp);
+      fmt::format_to(out, "\nCore{}: {}%", i - 1, tmp);
     }
     usage.push_back(tmp);
   }
-  prev_times = curr_times;
   return {usage, tooltip};
 }
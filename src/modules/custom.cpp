@@ -1,9 +1,51 @@
 #include "modules/custom.hpp"
 
 #include <spdlog/spdlog.h>
+#include <sys/socket.h>
 
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "util/exec_cache.hpp"
 #include "util/scope_guard.hpp"
 
+namespace {
+// Run "exec-if" of `config`, through the exec cache if "exec-cache" is set. Only its exit code
+// matters, what it printed is not shown.
+waybar::util::command::res execIf(const Json::Value& config) {
+  auto cmd = config["exec-if"].asString();
+  if (auto ttl = waybar::util::ExecCache::ttl(config)) {
+    return {waybar::util::ExecCache::inst().exec(cmd, "", *ttl).exit_code, ""};
+  }
+  return waybar::util::command::execNoRead(cmd);
+}
+
+// Run "exec" of `config`, through the exec cache if "exec-cache" is set
+waybar::util::command::res exec(const Json::Value& config, const std::string& output_name) {
+  auto cmd = config["exec"].asString();
+  if (auto ttl = waybar::util::ExecCache::ttl(config)) {
+    return waybar::util::ExecCache::inst().exec(cmd, output_name, *ttl);
+  }
+  return waybar::util::command::exec(cmd, output_name);
+}
+
+// Lines of a raw record pushed on one line, separated by "\n". "\\" is a backslash.
+std::string unescapeLines(const std::string& record) {
+  std::string lines;
+  lines.reserve(record.size());
+  for (size_t i = 0; i < record.size(); i++) {
+    if (record[i] == '\\' && i + 1 < record.size() &&
+        (record[i + 1] == 'n' || record[i + 1] == '\\')) {
+      lines += record[++i] == 'n' ? '\n' : '\\';
+    } else {
+      lines += record[i];
+    }
+  }
+  return lines;
+}
+}  // namespace
+
 waybar::modules::Custom::Custom(const std::string& name, const std::string& id,
                                 const Json::Value& config, const std::string& output_name)
     : ALabel(config, "custom-" + name, id, "{}"),
@@ -13,27 +55,66 @@ waybar::modules::Custom::Custom(const std::string& name, const std::string& id,
       tooltip_format_enabled_{config_["tooltip-format"].isString()},
       percentage_(0),
       fp_(nullptr),
-      pid_(-1) {
+      pid_(-1),
+      coprocess_in_(-1),
+      coalesce_(false),
+      coalesce_period_(config_["coalesce"].isNumeric()
+                           ? std::chrono::milliseconds(std::max(
+                                 0L, static_cast<long>(config_["coalesce"].asDouble() * 1000)))
+                           : std::chrono::milliseconds(0)) {
   if (config.isNull()) {
     spdlog::warn("There is no configuration for 'custom/{}', element will be hidden", name);
   }
   dp.emit();
-  if (!config_["signal"].empty() && config_["interval"].empty() &&
-      config_["restart-interval"].empty()) {
-    waitingWorker();
+  const bool shared = config_["shared"].isBool() && config_["shared"].asBool() &&
+                      (config_["exec"].isString() || config_["exec-if"].isString());
+  if (config_["coprocess"].isBool() && config_["coprocess"].asBool() &&
+      config_["exec"].isString()) {
+    coprocessWorker();
+  } else if (config_["file"].isString()) {
+    fileWorker();
+  } else if (!config_["signal"].empty() && config_["interval"].empty() &&
+             config_["restart-interval"].empty()) {
+    if (shared) {
+      sharedWorker(std::chrono::milliseconds::max());
+    } else {
+      waitingWorker();
+    }
   } else if (interval_.count() > 0) {
-    delayWorker();
+    if (shared) {
+      sharedWorker(interval_);
+    } else {
+      delayWorker();
+    }
   } else if (config_["exec"].isString()) {
     continuousWorker();
   }
 }
 
 waybar::modules::Custom::~Custom() {
+  deferred_apply_.disconnect();
+#ifdef HAVE_PROCESS_REACTOR
+  reactor_watch_.reset();
+#endif
+  if (provider_) {
+    provider_->detach(dp);
+  }
+  // The worker owns the process and its pipes while it runs, and closes them when it exits
+  timer_.reset();
+  thread_.join();
   if (pid_ != -1) {
     killpg(pid_, SIGTERM);
     waitpid(pid_, NULL, 0);
     pid_ = -1;
   }
+  if (fp_) {
+    fclose(fp_);
+    fp_ = nullptr;
+  }
+  if (coprocess_in_ != -1) {
+    ::close(coprocess_in_);
+    coprocess_in_ = -1;
+  }
 }
 
 void waybar::modules::Custom::delayWorker() {
@@ -47,7 +128,7 @@ void waybar::modules::Custom::delayWorker() {
 
     bool can_update = true;
     if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
+      output_ = execIf(config_);
       if (output_.exit_code != 0) {
         can_update = false;
         dp.emit();
@@ -55,15 +136,37 @@ void waybar::modules::Custom::delayWorker() {
     }
     if (can_update) {
       if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString(), output_name_);
+        output_ = exec(config_, output_name_);
       }
       dp.emit();
     }
-    thread_.sleep_for(interval_);
+    thread_.sleep();
   };
+  // The command runs on our own thread, the shared scheduler only provides the aligned wakeups
+  timer_ = util::Scheduler::inst().schedule(
+      interval_, [this] { thread_.wake_up(); }, false);
 }
 
 void waybar::modules::Custom::continuousWorker() {
+  coalesce_ = config_["coalesce"].isNumeric() ||
+              (config_["coalesce"].isBool() && config_["coalesce"].asBool());
+#ifdef HAVE_PROCESS_REACTOR
+  util::ProcessReactor::Command command{config_["exec"].asString(), output_name_};
+  if (config_["restart-interval"].isNumeric()) {
+    command.restart_interval = std::chrono::milliseconds(
+        std::max(1L,  // Minimum 1ms due to millisecond precision
+                 static_cast<long>(config_["restart-interval"].asDouble() * 1000)));
+  }
+  util::ProcessReactor::Handler handler;
+  handler.line = [this](std::string line) { publish({0, std::move(line)}); };
+  handler.exit = [this](int exit_code) {
+    if (exit_code != 0) {
+      publish({exit_code, ""});
+      spdlog::error("{} stopped unexpectedly, is it endless?", name_);
+    }
+  };
+  reactor_watch_ = util::ProcessReactor::inst().watch(std::move(command), std::move(handler));
+#else
   auto cmd = config_["exec"].asString();
   pid_ = -1;
   fp_ = util::command::open(cmd, pid_, output_name_);
@@ -81,12 +184,12 @@ void waybar::modules::Custom::continuousWorker() {
     if (getline(&buff, &len, fp_) == -1) {
       int exit_code = 1;
       if (fp_) {
-        exit_code = WEXITSTATUS(util::command::close(fp_, pid_));
-        fp_ = nullptr;
+        // Cleared first: the destructor must not close them again if this is cancelled
+        exit_code = WEXITSTATUS(util::command::close(std::exchange(fp_, nullptr), pid_));
+        pid_ = -1;
       }
       if (exit_code != 0) {
-        output_ = {exit_code, ""};
-        dp.emit();
+        publish({exit_code, ""});
         spdlog::error("{} stopped unexpectedly, is it endless?", name_);
       }
       if (config_["restart-interval"].isNumeric()) {
@@ -109,17 +212,190 @@ void waybar::modules::Custom::continuousWorker() {
       if (!output.empty() && output[output.length() - 1] == '\n') {
         output.erase(output.length() - 1);
       }
-      output_ = {0, output};
+      publish({0, output});
+    }
+  };
+#endif
+}
+
+/**
+ * Show the content of "file" every time it is written, or each line written to it if it is a
+ * named pipe. Nothing is forked: the reactor thread reads the file on inotify events.
+ */
+void waybar::modules::Custom::fileWorker() {
+  coalesce_ = config_["coalesce"].isNumeric() ||
+              (config_["coalesce"].isBool() && config_["coalesce"].asBool());
+#ifdef HAVE_PROCESS_REACTOR
+  reactor_watch_ = util::ProcessReactor::inst().watchFile(
+      config_["file"].asString(),
+      [this](std::string content) { publish({0, std::move(content)}); });
+#else
+  spdlog::error("{}: watching files is not supported on this platform", name_);
+#endif
+}
+
+/**
+ * Start `exec` once and write a "tick" line to its stdin at every interval, signal or event.
+ * The script answers each request with one record on stdout: a json line, or raw lines ended by
+ * an empty line. The interpreter stays warm, nothing is forked in the steady state.
+ */
+void waybar::modules::Custom::coprocessWorker() {
+  static constexpr std::string_view REQUEST = "tick\n";
+  auto cmd = config_["exec"].asString();
+  const bool json = config_["return-type"].asString() == "json";
+  thread_ = [this, cmd, json] {
+    if (!fp_) {
+      pid_ = -1;
+      fp_ = util::command::openCoprocess(cmd, pid_, coprocess_in_, output_name_);
+      if (!fp_) {
+        spdlog::error("{}: unable to open {}", name_, cmd);
+        thread_.stop();
+        return;
+      }
+    }
+    bool can_update = true;
+    if (config_["exec-if"].isString()) {
+      output_ = execIf(config_);
+      if (output_.exit_code != 0) {
+        can_update = false;
+        dp.emit();
+      }
+    }
+    if (!can_update) {
+      thread_.sleep();
+      return;
+    }
+
+    char* buff = nullptr;
+    waybar::util::ScopeGuard buff_deleter([&buff]() {
+      if (buff) {
+        free(buff);
+      }
+    });
+    size_t len = 0;
+    std::string record;
+    bool answered = send(coprocess_in_, REQUEST.data(), REQUEST.size(), MSG_NOSIGNAL) ==
+                    static_cast<ssize_t>(REQUEST.size());
+    while (answered) {
+      auto n = getline(&buff, &len, fp_);
+      if (n == -1) {
+        answered = false;
+        break;
+      }
+      std::string_view line(buff, n);
+      if (line.ends_with('\n')) {
+        line.remove_suffix(1);
+      }
+      if (!json && line.empty()) {
+        break;
+      }
+      if (!record.empty()) {
+        record += '\n';
+      }
+      record += line;
+      if (json) {
+        break;
+      }
+    }
+
+    if (answered) {
+      output_ = {0, std::move(record)};
       dp.emit();
+      thread_.sleep();
+      return;
+    }
+    // The script exited: it has to keep answering requests for as long as the bar runs
+    // Cleared first: the destructor must not close them again if this is cancelled
+    ::close(std::exchange(coprocess_in_, -1));
+    int exit_code = WEXITSTATUS(util::command::close(std::exchange(fp_, nullptr), pid_));
+    pid_ = -1;
+    output_ = {exit_code != 0 ? exit_code : 1, ""};
+    dp.emit();
+    spdlog::error("{} stopped unexpectedly, a coprocess must answer every request", name_);
+    if (config_["restart-interval"].isNumeric()) {
+      thread_.sleep_for(std::chrono::milliseconds(
+          std::max(1L,  // Minimum 1ms due to millisecond precision
+                   static_cast<long>(config_["restart-interval"].asDouble() * 1000))));
+    } else {
+      thread_.stop();
     }
   };
+  // Without an interval, only signals and events send requests
+  if (!config_["interval"].empty()) {
+    timer_ = util::Scheduler::inst().schedule(
+        interval_, [this] { thread_.wake_up(); }, false);
+  }
+}
+
+void waybar::modules::Custom::publish(util::command::res output) {
+  if (!coalesce_) {
+    output_ = std::move(output);
+    dp.emit();
+    return;
+  }
+  // Parse here, off the main loop: update() only applies the latest record
+  Record record;
+  if (output.exit_code == 0 && !output.out.empty()) {
+    // Not on the main loop, where update() errors are caught: a malformed record is dropped
+    try {
+      record = parseOutput(output.out);
+    } catch (const std::exception& e) {
+      spdlog::error("{}: {}", name_, e.what());
+      return;
+    }
+  }
+  bool idle;
+  {
+    std::lock_guard lock(pending_mutex_);
+    idle = !pending_;
+    pending_.emplace(std::move(output), std::move(record));
+  }
+  if (idle) {
+    dp.emit();
+  } else {
+    stats()->dropped++;
+  }
+}
+
+bool waybar::modules::Custom::takePending() {
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_apply_) {
+    // Too early, show the latest record once the period elapsed
+    if (!deferred_apply_.connected()) {
+      auto delay = std::chrono::ceil<std::chrono::milliseconds>(next_apply_ - now);
+      deferred_apply_ = Glib::signal_timeout().connect(
+          [this] {
+            dp.emit();
+            return false;
+          },
+          delay.count());
+    }
+    return false;
+  }
+  std::optional<std::pair<util::command::res, Record>> pending;
+  {
+    std::lock_guard lock(pending_mutex_);
+    pending.swap(pending_);
+  }
+  if (!pending) {
+    return false;
+  }
+  next_apply_ = now + coalesce_period_;
+  output_ = std::move(pending->first);
+  auto& record = pending->second;
+  text_ = std::move(record.text);
+  alt_ = std::move(record.alt);
+  tooltip_ = std::move(record.tooltip);
+  class_ = std::move(record.classes);
+  percentage_ = record.percentage;
+  return true;
 }
 
 void waybar::modules::Custom::waitingWorker() {
   thread_ = [this] {
     bool can_update = true;
     if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
+      output_ = execIf(config_);
       if (output_.exit_code != 0) {
         can_update = false;
         dp.emit();
@@ -127,7 +403,7 @@ void waybar::modules::Custom::waitingWorker() {
     }
     if (can_update) {
       if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString(), output_name_);
+        output_ = exec(config_, output_name_);
       }
       dp.emit();
     }
@@ -135,16 +411,62 @@ void waybar::modules::Custom::waitingWorker() {
   };
 }
 
+void waybar::modules::Custom::sharedWorker(std::chrono::milliseconds interval) {
+  provider_ = util::Provider::get<CustomProvider>("custom", config_, [this, interval] {
+    return std::make_shared<CustomProvider>(config_, interval);
+  });
+  provider_->attach(dp);
+  spdlog::debug("{}: sharing commands with {} other bar(s)", name_,
+                provider_->subscribers() - 1);
+}
+
 void waybar::modules::Custom::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    if (provider_) {
+      provider_->wakeUp();
+    } else {
+      thread_.wake_up();
+    }
   }
 }
 
 void waybar::modules::Custom::handleEvent() {
   if (!config_["exec-on-event"].isBool() || config_["exec-on-event"].asBool()) {
-    thread_.wake_up();
+    if (provider_) {
+      provider_->wakeUp();
+    } else {
+      thread_.wake_up();
+    }
+  }
+}
+
+void waybar::modules::Custom::triggerEvent(const std::string& event) {
+  ALabel::triggerEvent(event);
+  handleEvent();
+}
+
+Json::Value waybar::modules::Custom::state() const {
+  auto state = ALabel::state();
+  state["alt"] = alt_;
+  state["percentage"] = percentage_;
+  return state;
+}
+
+bool waybar::modules::Custom::push(std::string record) {
+  if (provider_) {
+    return false;
+  }
+  if (config_["return-type"].asString() != "json") {
+    record = unescapeLines(record);
+  }
+  if (coalesce_) {
+    publish({0, std::move(record)});
+  } else {
+    // Workers write output_ on their own thread, update() takes it from here on the main loop
+    std::lock_guard lock(pending_mutex_);
+    pushed_ = util::command::res{0, std::move(record)};
   }
+  return true;
 }
 
 bool waybar::modules::Custom::handleScroll(GdkEventScroll* e) {
@@ -160,15 +482,31 @@ bool waybar::modules::Custom::handleToggle(GdkEventButton* const& e) {
 }
 
 auto waybar::modules::Custom::update() -> void {
+  if (provider_) {
+    output_ = provider_->output();
+  } else if (!coalesce_) {
+    std::lock_guard lock(pending_mutex_);
+    if (pushed_) {
+      output_ = std::move(*pushed_);
+      pushed_.reset();
+    }
+  }
+  // Coalesced records are parsed already, updates without one keep showing the current one
+  if (coalesce_) {
+    takePending();
+  }
   // Hide label if output is empty
-  if ((config_["exec"].isString() || config_["exec-if"].isString()) &&
+  if ((config_["exec"].isString() || config_["exec-if"].isString() || config_["file"].isString()) &&
       (output_.out.empty() || output_.exit_code != 0)) {
     event_box_.hide();
   } else {
-    if (config_["return-type"].asString() == "json") {
-      parseOutputJson();
-    } else {
-      parseOutputRaw();
+    if (!coalesce_) {
+      auto record = parseOutput(output_.out);
+      text_ = std::move(record.text);
+      alt_ = std::move(record.alt);
+      tooltip_ = std::move(record.tooltip);
+      class_ = std::move(record.classes);
+      percentage_ = record.percentage;
     }
 
     try {
@@ -196,18 +534,19 @@ auto waybar::modules::Custom::update() -> void {
             }
           }
         }
-        auto style = label_.get_style_context();
-        auto classes = style->list_classes();
-        for (auto const& c : classes) {
-          if (c == id_) continue;
-          style->remove_class(c);
+        // Only touch the style context for the classes that changed since the last update
+        for (const auto& c : label_class_) {
+          if (c != id_ && std::ranges::find(class_, c) == class_.end()) {
+            label_.remove_class(c);
+          }
         }
-        for (auto const& c : class_) {
-          style->add_class(c);
+        for (const auto& c : class_) {
+          label_.add_class(c);
         }
-        style->add_class("flat");
-        style->add_class("text-button");
-        style->add_class(MODULE_CLASS);
+        label_class_ = class_;
+        label_.add_class("flat");
+        label_.add_class("text-button");
+        label_.add_class(MODULE_CLASS);
         event_box_.show();
       }
     } catch (const fmt::format_error& e) {
@@ -223,8 +562,18 @@ auto waybar::modules::Custom::update() -> void {
   ALabel::update();
 }
 
-void waybar::modules::Custom::parseOutputRaw() {
-  std::istringstream output(output_.out);
+waybar::modules::Custom::Record waybar::modules::Custom::parseOutput(const std::string& out) {
+  Record record;
+  if (config_["return-type"].asString() == "json") {
+    parseOutputJson(out, record);
+  } else {
+    parseOutputRaw(out, record);
+  }
+  return record;
+}
+
+void waybar::modules::Custom::parseOutputRaw(const std::string& out, Record& record) const {
+  std::istringstream output(out);
   std::string line;
   int i = 0;
   while (getline(output, line)) {
@@ -235,22 +584,22 @@ void waybar::modules::Custom::parseOutputRaw() {
 
     if (i == 0) {
       if (config_["escape"].isBool() && config_["escape"].asBool()) {
-        text_ = Glib::Markup::escape_text(validated_line);
-        tooltip_ = Glib::Markup::escape_text(validated_line);
+        record.text = Glib::Markup::escape_text(validated_line);
+        record.tooltip = Glib::Markup::escape_text(validated_line);
       } else {
-        text_ = validated_line;
-        tooltip_ = validated_line;
+        record.text = validated_line;
+        record.tooltip = validated_line;
       }
-      tooltip_ = validated_line;
-      class_.clear();
+      record.tooltip = validated_line;
+      record.classes.clear();
     } else if (i == 1) {
       if (config_["escape"].isBool() && config_["escape"].asBool()) {
-        tooltip_ = Glib::Markup::escape_text(validated_line);
+        record.tooltip = Glib::Markup::escape_text(validated_line);
       } else {
-        tooltip_ = validated_line;
+        record.tooltip = validated_line;
       }
     } else if (i == 2) {
-      class_.push_back(validated_line);
+      record.classes.push_back(validated_line);
     } else {
       break;
     }
@@ -258,39 +607,70 @@ void waybar::modules::Custom::parseOutputRaw() {
   }
 }
 
-void waybar::modules::Custom::parseOutputJson() {
-  std::istringstream output(output_.out);
+void waybar::modules::Custom::parseOutputJson(const std::string& out, Record& record) {
+  std::istringstream output(out);
   std::string line;
-  class_.clear();
+  record.classes.clear();
   while (getline(output, line)) {
     auto parsed = parser_.parse(line);
     if (config_["escape"].isBool() && config_["escape"].asBool()) {
-      text_ = Glib::Markup::escape_text(parsed["text"].asString());
+      record.text = Glib::Markup::escape_text(parsed["text"].asString());
     } else {
-      text_ = parsed["text"].asString();
+      record.text = parsed["text"].asString();
     }
     if (config_["escape"].isBool() && config_["escape"].asBool()) {
-      alt_ = Glib::Markup::escape_text(parsed["alt"].asString());
+      record.alt = Glib::Markup::escape_text(parsed["alt"].asString());
     } else {
-      alt_ = parsed["alt"].asString();
+      record.alt = parsed["alt"].asString();
     }
     if (config_["escape"].isBool() && config_["escape"].asBool()) {
-      tooltip_ = Glib::Markup::escape_text(parsed["tooltip"].asString());
+      record.tooltip = Glib::Markup::escape_text(parsed["tooltip"].asString());
     } else {
-      tooltip_ = parsed["tooltip"].asString();
+      record.tooltip = parsed["tooltip"].asString();
     }
     if (parsed["class"].isString()) {
-      class_.push_back(parsed["class"].asString());
+      record.classes.push_back(parsed["class"].asString());
     } else if (parsed["class"].isArray()) {
       for (auto const& c : parsed["class"]) {
-        class_.push_back(c.asString());
+        record.classes.push_back(c.asString());
       }
     }
     if (!parsed["percentage"].asString().empty() && parsed["percentage"].isNumeric()) {
-      percentage_ = (int)lround(parsed["percentage"].asFloat());
+      record.percentage = (int)lround(parsed["percentage"].asFloat());
     } else {
-      percentage_ = 0;
+      record.percentage = 0;
     }
     break;
   }
 }
+
+waybar::modules::CustomProvider::CustomProvider(const Json::Value& config,
+                                                std::chrono::milliseconds interval)
+    : config_(config), output_{0, ""} {
+  thread_ = [this] {
+    util::command::res output{0, ""};
+    bool can_update = true;
+    if (config_["exec-if"].isString()) {
+      output = execIf(config_);
+      can_update = output.exit_code == 0;
+    }
+    // The commands are shared between outputs, so WAYBAR_OUTPUT_NAME is not set
+    if (can_update && config_["exec"].isString()) {
+      output = exec(config_, "");
+    }
+    {
+      std::lock_guard lock(output_mutex_);
+      output_ = std::move(output);
+    }
+    samples_++;
+    notify();
+    thread_.sleep();
+  };
+  timer_ = util::Scheduler::inst().schedule(
+      interval, [this] { thread_.wake_up(); }, false);
+}
+
+waybar::util::command::res waybar::modules::CustomProvider::output() const {
+  std::lock_guard lock(output_mutex_);
+  return output_;
+}
@@ -4,20 +4,36 @@ using namespace waybar::util;
 
 waybar::modules::Disk::Disk(const std::string& id, const Json::Value& config)
     : ALabel(config, "disk", id, "{}%", 30), path_("/") {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
   if (config["path"].isString()) {
     path_ = config["path"].asString();
   }
   if (config["unit"].isString()) {
     unit_ = config["unit"].asString();
   }
+  sampler_ = util::SystemSampler::inst().subscribe(
+      interval_, {util::SystemSampler::MOUNTS, {}, {path_}}, &dp);
 }
 
 auto waybar::modules::Disk::update() -> void {
-  struct statvfs /* {
+  auto snapshot = sampler_.snapshot();
+  if (!snapshot) {
+    return;
+  }
+  auto mount = snapshot->mounts.find(path_);
+  if (mount == snapshot->mounts.end()) {
+    // statvfs() failed
+    event_box_.hide();
+    return;
+  }
+  if (mount->second.changed <= rendered_version_ && format_ == rendered_format_) {
+    // Neither the usage nor the format (format-alt) changed since the last render
+    return;
+  }
+  rendered_version_ = snapshot->version;
+  rendered_format_ = format_;
+
+  // statvfs() of path_, sampled by the system sampler
+  const struct statvfs /* {
       unsigned long  f_bsize;    // filesystem block size
       unsigned long  f_frsize;   // fragment size
       fsblkcnt_t     f_blocks;   // size of fs in f_frsize units
@@ -30,8 +46,7 @@ auto waybar::modules::Disk::update() -> void {
       unsigned long  f_flag;     // mount flags
       unsigned long  f_namemax;  // maximum filename length
   }; */
-      stats;
-  int err = statvfs(path_.c_str(), &stats);
+      &stats = mount->second.stats;
 
   /* Conky options
     fs_bar - Bar that shows how much space is used
@@ -41,11 +56,6 @@ auto waybar::modules::Disk::update() -> void {
     fs_used - File system used space
   */
 
-  if (err != 0) {
-    event_box_.hide();
-    return;
-  }
-
   float specific_free, specific_used, specific_total, divisor;
 
   divisor = calc_specific_divisor(unit_);
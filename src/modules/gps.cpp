@@ -146,7 +146,7 @@ auto waybar::modules::Gps::update() -> void {
   if (!alt_) {
     auto state = getFixModeName();
     if (!state_.empty() && label_.get_style_context()->has_class(state_)) {
-      label_.get_style_context()->remove_class(state_);
+      label_.remove_class(state_);
     }
     if (config_["format-" + state].isString()) {
       default_format_ = config_["format-" + state].asString();
@@ -159,7 +159,7 @@ auto waybar::modules::Gps::update() -> void {
       tooltip_format = config_["tooltip-format-" + state].asString();
     }
     if (!label_.get_style_context()->has_class(state)) {
-      label_.get_style_context()->add_class(state);
+      label_.add_class(state);
     }
     format_ = default_format_;
     state_ = state;
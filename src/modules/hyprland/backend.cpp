@@ -1,14 +1,19 @@
 #include "modules/hyprland/backend.hpp"
 
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <spdlog/spdlog.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <array>
+#include <cstring>
 #include <filesystem>
 #include <string>
 
@@ -44,6 +49,10 @@ std::filesystem::path IPC::getSocketFolder(const char* instanceSig) {
 }
 
 IPC::IPC() {
+  wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wakeFd_ == -1) {
+    throw std::runtime_error(std::string("Hyprland IPC: eventfd failed: ") + strerror(errno));
+  }
   // will start IPC and relay events to parseIPC
   ipcThread_ = std::thread([this]() { socketListener(); });
   socketOwnerPid_ = getpid();
@@ -56,17 +65,18 @@ IPC::~IPC() {
 
   running_ = false;
   spdlog::info("Hyprland IPC stopping...");
+  uint64_t one = 1;
+  if (write(wakeFd_, &one, sizeof(one)) == -1) {
+    spdlog::error("Hyprland IPC: Couldn't wake the listener");
+  }
+  ipcThread_.join();
   if (socketfd_ != -1) {
-    spdlog::trace("Shutting down socket");
-    if (shutdown(socketfd_, SHUT_RDWR) == -1) {
-      spdlog::error("Hyprland IPC: Couldn't shutdown socket");
-    }
     spdlog::trace("Closing socket");
     if (close(socketfd_) == -1) {
       spdlog::error("Hyprland IPC: Couldn't close socket");
     }
   }
-  ipcThread_.join();
+  close(wakeFd_);
 }
 
 IPC& IPC::inst() {
@@ -88,7 +98,7 @@ void IPC::socketListener() {
   spdlog::info("Hyprland IPC starting");
 
   struct sockaddr_un addr;
-  socketfd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  socketfd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 
   if (socketfd_ == -1) {
     spdlog::error("Hyprland IPC: socketfd failed");
@@ -108,46 +118,73 @@ void IPC::socketListener() {
     spdlog::error("Hyprland IPC: Unable to connect?");
     return;
   }
-  auto* file = fdopen(socketfd_, "r");
-  if (file == nullptr) {
-    spdlog::error("Hyprland IPC: Couldn't open file descriptor");
+  if (fcntl(socketfd_, F_SETFL, fcntl(socketfd_, F_GETFL) | O_NONBLOCK) == -1) {
+    spdlog::error("Hyprland IPC: Couldn't make the socket non-blocking");
     return;
   }
-  while (running_) {
-    std::array<char, 1024> buffer;  // Hyprland socket2 events are max 1024 bytes
-
-    auto* receivedCharPtr = fgets(buffer.data(), buffer.size(), file);
+  setQueryCacheEnabled(true);
 
-    if (receivedCharPtr == nullptr) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-      continue;
+  std::array<pollfd, 2> fds = {{{socketfd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}}};
+  // Events not terminated by a newline yet
+  std::string buffer;
+  std::array<char, 4096> chunk;
+  while (running_) {
+    if (poll(fds.data(), fds.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      spdlog::error("Hyprland IPC: poll failed: {}", strerror(errno));
+      break;
     }
-
-    std::string messageReceived(buffer.data());
-    messageReceived = messageReceived.substr(0, messageReceived.find_first_of('\n'));
-    spdlog::debug("hyprland IPC received {}", messageReceived);
-
-    try {
-      parseIPC(messageReceived);
-    } catch (std::exception& e) {
-      spdlog::warn("Failed to parse IPC message: {}, reason: {}", messageReceived, e.what());
-    } catch (...) {
-      throw;
+    if (fds[1].revents != 0) {
+      break;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Every event of a burst is read and dispatched before waiting again
+    ssize_t n;
+    while ((n = read(socketfd_, chunk.data(), chunk.size())) > 0) {
+      buffer.append(chunk.data(), n);
+      size_t start = 0;
+      size_t end;
+      while ((end = buffer.find('\n', start)) != std::string::npos) {
+        std::string messageReceived = buffer.substr(start, end - start);
+        start = end + 1;
+        spdlog::debug("hyprland IPC received {}", messageReceived);
+
+        try {
+          parseIPC(messageReceived);
+        } catch (std::exception& e) {
+          spdlog::warn("Failed to parse IPC message: {}, reason: {}", messageReceived, e.what());
+        }
+      }
+      buffer.erase(0, start);
+    }
+    if (n == 0) {
+      spdlog::warn("Hyprland IPC: socket2 was closed");
+      break;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      spdlog::error("Hyprland IPC: Couldn't read socket2: {}", strerror(errno));
+      break;
+    }
   }
+  setQueryCacheEnabled(false);
   spdlog::debug("Hyprland IPC stopped");
 }
 
 void IPC::parseIPC(const std::string& ev) {
   std::string request = ev.substr(0, ev.find_first_of('>'));
+  // Every event may change what the queries return, not only the ones modules listen to
+  nextGeneration();
+  updateState(ev);
   std::unique_lock lock(callbackMutex_);
 
-  for (auto& [eventname, handler] : callbacks_) {
-    if (eventname == request) {
-      handler->onEvent(ev);
-    }
+  auto handlers = callbacks_.find(request);
+  if (handlers == callbacks_.end()) {
+    return;
+  }
+  for (auto* handler : handlers->second) {
+    handler->onEvent(ev);
   }
 }
 
@@ -157,7 +194,7 @@ void IPC::registerForIPC(const std::string& ev, EventHandler* ev_handler) {
   }
 
   std::unique_lock lock(callbackMutex_);
-  callbacks_.emplace_back(ev, ev_handler);
+  callbacks_[ev].push_back(ev_handler);
 }
 
 void IPC::unregisterForIPC(EventHandler* ev_handler) {
@@ -168,9 +205,9 @@ void IPC::unregisterForIPC(EventHandler* ev_handler) {
   std::unique_lock lock(callbackMutex_);
 
   for (auto it = callbacks_.begin(); it != callbacks_.end();) {
-    auto& [eventname, handler] = *it;
-    if (handler == ev_handler) {
-      callbacks_.erase(it++);
+    std::erase(it->second, ev_handler);
+    if (it->second.empty()) {
+      it = callbacks_.erase(it);
     } else {
       ++it;
     }
@@ -236,13 +273,176 @@ std::string IPC::getSocket1Reply(const std::string& rq) {
 }
 
 Json::Value IPC::getSocket1JsonReply(const std::string& rq) {
-  std::string reply = getSocket1Reply("j/" + rq);
+  return *getSocket1JsonReplyShared(rq);
+}
 
-  if (reply.empty()) {
-    return {};
+std::shared_ptr<const Json::Value> IPC::getSocket1JsonReplyShared(const std::string& rq) {
+  return getSocket1JsonReplies({rq}).front();
+}
+
+std::vector<std::shared_ptr<const Json::Value>> IPC::getSocket1JsonReplies(
+    const std::vector<std::string>& rqs) {
+  if (!queryCacheEnabled_) {
+    return query(rqs);
   }
 
-  return parser_.parse(reply);
+  std::vector<std::shared_ptr<const Json::Value>> replies(rqs.size());
+  std::unique_lock lock(queryMutex_);
+  while (true) {
+    auto generation = generation_.load();
+    // Indices of the queries this caller sends, and whether others run the rest
+    std::vector<size_t> sent;
+    bool waiting = false;
+    for (size_t i = 0; i < rqs.size(); i++) {
+      if (replies[i]) {
+        continue;
+      }
+      // References to map entries stay valid while other entries are added
+      auto& entry = queries_[rqs[i]];
+      if (entry.running) {
+        waiting = true;
+      } else if (entry.reply && entry.generation == generation) {
+        replies[i] = entry.reply;
+      } else {
+        entry.running = true;
+        sent.push_back(i);
+      }
+    }
+
+    if (!sent.empty()) {
+      std::vector<std::string> batch;
+      for (auto i : sent) {
+        batch.push_back(rqs[i]);
+      }
+      lock.unlock();
+      std::vector<std::shared_ptr<const Json::Value>> received;
+      try {
+        received = query(batch);
+      } catch (...) {
+        lock.lock();
+        for (auto i : sent) {
+          queries_[rqs[i]].running = false;
+        }
+        queryDone_.notify_all();
+        throw;
+      }
+      lock.lock();
+      for (size_t j = 0; j < sent.size(); j++) {
+        // Tagged with the generation it was sent in: an event read meanwhile makes it stale
+        auto& entry = queries_[rqs[sent[j]]];
+        entry.reply = received[j];
+        entry.generation = generation;
+        entry.running = false;
+        replies[sent[j]] = received[j];
+      }
+      queryDone_.notify_all();
+    } else if (waiting) {
+      queryDone_.wait(lock);
+    } else {
+      return replies;
+    }
+  }
+}
+
+std::vector<std::shared_ptr<const Json::Value>> IPC::query(const std::vector<std::string>& rqs) {
+  std::vector<std::string> replies;
+  if (rqs.size() == 1) {
+    replies.push_back(getSocket1Reply("j/" + rqs.front()));
+  } else {
+    std::string batch = "[[BATCH]]";
+    for (const auto& rq : rqs) {
+      batch += (&rq == &rqs.front() ? "j/" : ";j/") + rq;
+    }
+    replies = splitBatchReply(getSocket1Reply(batch));
+    if (replies.size() != rqs.size()) {
+      throw std::runtime_error("Hyprland IPC: Batch of " + std::to_string(rqs.size()) +
+                               " requests got " + std::to_string(replies.size()) + " replies");
+    }
+  }
+
+  std::vector<std::shared_ptr<const Json::Value>> parsed;
+  parsed.reserve(replies.size());
+  for (const auto& reply : replies) {
+    parsed.push_back(reply.empty() ? std::make_shared<const Json::Value>()
+                                   : std::make_shared<const Json::Value>(parser_.parse(reply)));
+  }
+  return parsed;
+}
+
+std::vector<std::string> IPC::splitBatchReply(std::string_view reply) {
+  // Hyprland versions differ in what they put between the replies, so the top-level JSON values
+  // are delimited by their brackets instead
+  std::vector<std::string> replies;
+  size_t start = std::string_view::npos;
+  int depth = 0;
+  bool inString = false;
+  for (size_t i = 0; i < reply.size(); i++) {
+    char c = reply[i];
+    if (inString) {
+      if (c == '\\') {
+        i++;
+      } else if (c == '"') {
+        inString = false;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      if (depth++ == 0) {
+        start = i;
+      }
+    } else if ((c == '}' || c == ']') && depth > 0 && --depth == 0) {
+      replies.emplace_back(reply.substr(start, i + 1 - start));
+    }
+  }
+  return replies;
+}
+
+void IPC::setQueryCacheEnabled(bool enabled) {
+  queryCacheEnabled_ = enabled;
+  // Callers may still wait on an entry, it is dropped by its generation instead of erased
+  nextGeneration();
+  std::unique_lock lock(stateMutex_);
+  state_.reset();
+}
+
+std::shared_ptr<const State> IPC::getState() {
+  uint64_t generation;
+  {
+    std::unique_lock lock(stateMutex_);
+    if (state_ && queryCacheEnabled_) {
+      return state_;
+    }
+    generation = generation_;
+  }
+  // Not under the lock: the listener updating the state would wait for the round trip
+  auto replies = getSocket1JsonReplies({"monitors", "workspaces", "clients"});
+  auto state = std::make_shared<State>(State::fromJson(*replies[0], *replies[1], *replies[2]));
+
+  std::unique_lock lock(stateMutex_);
+  // Without the listener nothing would keep it up to date. An event since the query may not be
+  // in the replies, the next call reads the state again.
+  if (queryCacheEnabled_ && generation_ == generation) {
+    state_ = state;
+  }
+  return state;
+}
+
+void IPC::updateState(const std::string& ev) {
+  if (!State::tracks(std::string_view(ev).substr(0, ev.find(">>")))) {
+    return;
+  }
+  std::unique_lock lock(stateMutex_);
+  if (!state_) {
+    return;
+  }
+  // Readers only get the state under the lock, a count of one can't grow meanwhile
+  if (state_.use_count() > 1) {
+    state_ = std::make_shared<State>(*state_);
+  }
+  if (!state_->apply(ev)) {
+    spdlog::debug("Hyprland IPC: state drifted at {}, reading it again", ev);
+    state_.reset();
+  }
 }
 
 }  // namespace waybar::modules::hyprland
@@ -0,0 +1,416 @@
+#include "modules/hyprland/state.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <optional>
+#include <unordered_set>
+
+namespace waybar::modules::hyprland {
+
+namespace {
+std::string stripAddress(std::string address) {
+  if (address.starts_with("0x")) {
+    address.erase(0, 2);
+  }
+  return address;
+}
+
+// The first `N` comma separated fields of `payload`, the last one taking the rest of it
+template <size_t N>
+std::optional<std::array<std::string_view, N>> split(std::string_view payload) {
+  std::array<std::string_view, N> fields;
+  for (size_t i = 0; i + 1 < N; i++) {
+    auto comma = payload.find(',');
+    if (comma == std::string_view::npos) {
+      return std::nullopt;
+    }
+    fields[i] = payload.substr(0, comma);
+    payload.remove_prefix(comma + 1);
+  }
+  fields[N - 1] = payload;
+  return fields;
+}
+
+std::optional<int> toInt(std::string_view str) {
+  int value;
+  auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+  if (ec != std::errc() || end != str.data() + str.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+}  // namespace
+
+State State::fromJson(const Json::Value& monitors, const Json::Value& workspaces,
+                      const Json::Value& clients) {
+  State state;
+  for (const auto& monitor : monitors) {
+    state.monitors.push_back({
+        .id = monitor["id"].asInt(),
+        .name = monitor["name"].asString(),
+        .activeWorkspaceId = monitor["activeWorkspace"]["id"].asInt(),
+        .specialWorkspaceId = monitor["specialWorkspace"]["id"].asInt(),
+        .specialWorkspaceName = monitor["specialWorkspace"]["name"].asString(),
+        .focused = monitor["focused"].asBool(),
+    });
+  }
+  for (const auto& workspace : workspaces) {
+    auto id = workspace["id"].asInt();
+    state.workspaces[id] = {
+        .id = id,
+        .name = workspace["name"].asString(),
+        .monitor = workspace["monitor"].asString(),
+        .windows = workspace["windows"].asInt(),
+        .hasFullscreen = workspace["hasfullscreen"].asBool(),
+    };
+  }
+  for (const auto& client : clients) {
+    auto address = stripAddress(client["address"].asString());
+    state.clients[address] = {
+        .address = address,
+        .workspaceId = client["workspace"]["id"].asInt(),
+        .className = client["class"].asString(),
+        .initialClass = client["initialClass"].asString(),
+        .title = client["title"].asString(),
+        .initialTitle = client["initialTitle"].asString(),
+        .floating = client["floating"].asBool(),
+        .fullscreen = client["fullscreen"].asInt() != 0,
+        .mapped = client["mapped"].asBool(),
+        .hidden = client["hidden"].asBool(),
+    };
+    if (client["focusHistoryID"].isInt() && client["focusHistoryID"].asInt() == 0) {
+      state.activeWindow = address;
+    }
+  }
+  return state;
+}
+
+bool State::tracks(std::string_view name) {
+  static const std::unordered_set<std::string_view> EVENTS = {
+      "workspace",          "workspacev2",        "focusedmon",         "focusedmonv2",
+      "activespecial",      "activespecialv2",    "createworkspacev2",  "destroyworkspace",
+      "destroyworkspacev2", "moveworkspace",      "moveworkspacev2",    "renameworkspace",
+      "openwindow",         "closewindow",        "movewindow",         "movewindowv2",
+      "windowtitlev2",      "activewindowv2",     "changefloatingmode", "fullscreen",
+      "monitoradded",       "monitoraddedv2",     "monitorremoved",     "monitorremovedv2",
+      "configreloaded",
+  };
+  return EVENTS.contains(name);
+}
+
+bool State::apply(std::string_view ev) {
+  auto separator = ev.find(">>");
+  if (separator == std::string_view::npos) {
+    return true;
+  }
+  auto name = ev.substr(0, separator);
+  auto payload = ev.substr(separator + 2);
+
+  if (name == "workspace") {
+    auto* ws = workspace(payload);
+    return ws != nullptr && activate(ws->id);
+  }
+  if (name == "workspacev2") {
+    auto fields = split<2>(payload);
+    auto id = fields ? toInt((*fields)[0]) : std::nullopt;
+    return id && activate(*id);
+  }
+  if (name == "focusedmon" || name == "focusedmonv2") {
+    auto fields = split<2>(payload);
+    if (!fields) {
+      return false;
+    }
+    auto* mon = monitor((*fields)[0]);
+    const Workspace* ws = nullptr;
+    if (name == "focusedmon") {
+      ws = workspace((*fields)[1]);
+    } else if (auto id = toInt((*fields)[1])) {
+      ws = findWorkspace(*id);
+    }
+    if (mon == nullptr || ws == nullptr) {
+      return false;
+    }
+    for (auto& other : monitors) {
+      other.focused = &other == mon;
+    }
+    mon->activeWorkspaceId = ws->id;
+    return true;
+  }
+  if (name == "activespecial" || name == "activespecialv2") {
+    std::string_view wsName;
+    std::string_view monName;
+    if (name == "activespecial") {
+      auto fields = split<2>(payload);
+      if (!fields) {
+        return false;
+      }
+      wsName = (*fields)[0];
+      monName = (*fields)[1];
+    } else {
+      auto fields = split<3>(payload);
+      if (!fields) {
+        return false;
+      }
+      wsName = (*fields)[1];
+      monName = (*fields)[2];
+    }
+    auto* mon = monitor(monName);
+    if (mon == nullptr) {
+      return false;
+    }
+    if (wsName.empty()) {
+      mon->specialWorkspaceId = 0;
+      mon->specialWorkspaceName.clear();
+      return true;
+    }
+    auto* ws = workspace(wsName);
+    if (ws == nullptr) {
+      return false;
+    }
+    mon->specialWorkspaceId = ws->id;
+    mon->specialWorkspaceName = ws->name;
+    return true;
+  }
+  if (name == "createworkspacev2") {
+    // The event doesn't tell the monitor: it is the focused one unless a workspace or window rule
+    // put it elsewhere, and no moveworkspace follows then
+    return false;
+  }
+  if (name == "destroyworkspace") {
+    if (const auto* ws = workspace(payload)) {
+      workspaces.erase(ws->id);
+    }
+    return true;
+  }
+  if (name == "destroyworkspacev2") {
+    auto fields = split<2>(payload);
+    auto id = fields ? toInt((*fields)[0]) : std::nullopt;
+    if (!id) {
+      return false;
+    }
+    workspaces.erase(*id);
+    return true;
+  }
+  if (name == "moveworkspace" || name == "moveworkspacev2") {
+    Workspace* ws = nullptr;
+    std::string_view monName;
+    if (name == "moveworkspace") {
+      auto fields = split<2>(payload);
+      if (!fields) {
+        return false;
+      }
+      ws = workspace((*fields)[0]);
+      monName = (*fields)[1];
+    } else {
+      auto fields = split<3>(payload);
+      auto id = fields ? toInt((*fields)[0]) : std::nullopt;
+      if (!id || !workspaces.contains(*id)) {
+        return false;
+      }
+      ws = &workspaces[*id];
+      monName = (*fields)[2];
+    }
+    if (ws == nullptr || monitor(monName) == nullptr) {
+      return false;
+    }
+    ws->monitor = monName;
+    return true;
+  }
+  if (name == "renameworkspace") {
+    auto fields = split<2>(payload);
+    auto id = fields ? toInt((*fields)[0]) : std::nullopt;
+    if (!id || !workspaces.contains(*id)) {
+      return false;
+    }
+    workspaces[*id].name = (*fields)[1];
+    return true;
+  }
+  if (name == "openwindow") {
+    auto fields = split<4>(payload);
+    if (!fields) {
+      return false;
+    }
+    auto* ws = workspace((*fields)[1]);
+    if (ws == nullptr) {
+      return false;
+    }
+    std::string address((*fields)[0]);
+    clients[address] = {
+        .address = address,
+        .workspaceId = ws->id,
+        .className = std::string((*fields)[2]),
+        .initialClass = std::string((*fields)[2]),
+        .title = std::string((*fields)[3]),
+        .initialTitle = std::string((*fields)[3]),
+    };
+    refresh(ws->id);
+    return true;
+  }
+  if (name == "closewindow") {
+    auto client = clients.find(std::string(payload));
+    if (client != clients.end()) {
+      auto id = client->second.workspaceId;
+      clients.erase(client);
+      refresh(id);
+    }
+    if (activeWindow == payload) {
+      activeWindow.clear();
+    }
+    return true;
+  }
+  if (name == "movewindow" || name == "movewindowv2") {
+    auto fields = split<2>(payload);
+    if (!fields) {
+      return false;
+    }
+    auto client = clients.find(std::string((*fields)[0]));
+    const Workspace* ws = nullptr;
+    if (name == "movewindow") {
+      ws = workspace((*fields)[1]);
+    } else if (auto rest = split<2>((*fields)[1])) {
+      if (auto id = toInt((*rest)[0])) {
+        ws = findWorkspace(*id);
+      }
+    }
+    if (client == clients.end() || ws == nullptr) {
+      return false;
+    }
+    auto from = client->second.workspaceId;
+    client->second.workspaceId = ws->id;
+    refresh(from);
+    refresh(ws->id);
+    return true;
+  }
+  if (name == "windowtitlev2") {
+    auto fields = split<2>(payload);
+    if (!fields) {
+      return false;
+    }
+    auto client = clients.find(std::string((*fields)[0]));
+    if (client == clients.end()) {
+      return false;
+    }
+    client->second.title = (*fields)[1];
+    return true;
+  }
+  if (name == "activewindowv2") {
+    activeWindow = payload;
+    return activeWindow.empty() || clients.contains(activeWindow);
+  }
+  if (name == "changefloatingmode") {
+    auto fields = split<2>(payload);
+    if (!fields) {
+      return false;
+    }
+    auto client = clients.find(std::string((*fields)[0]));
+    if (client == clients.end()) {
+      return false;
+    }
+    client->second.floating = (*fields)[1] == "1";
+    return true;
+  }
+  if (name == "fullscreen") {
+    // The event doesn't tell the window, it is the focused one
+    auto client = clients.find(activeWindow);
+    if (client == clients.end()) {
+      return false;
+    }
+    client->second.fullscreen = payload == "1";
+    refresh(client->second.workspaceId);
+    return true;
+  }
+  // Monitors and config changes are read again rather than followed
+  return !tracks(name);
+}
+
+const State::Monitor* State::focusedMonitor() const {
+  auto it = std::ranges::find_if(monitors, [](const auto& mon) { return mon.focused; });
+  return it != monitors.end() ? &*it : nullptr;
+}
+
+const State::Monitor* State::findMonitor(std::string_view name) const {
+  auto it = std::ranges::find_if(monitors, [name](const auto& mon) { return mon.name == name; });
+  return it != monitors.end() ? &*it : nullptr;
+}
+
+const State::Workspace* State::findWorkspace(int id) const {
+  auto it = workspaces.find(id);
+  return it != workspaces.end() ? &it->second : nullptr;
+}
+
+const State::Workspace* State::findWorkspace(std::string_view name) const {
+  auto it =
+      std::ranges::find_if(workspaces, [name](const auto& ws) { return ws.second.name == name; });
+  return it != workspaces.end() ? &it->second : nullptr;
+}
+
+const State::Client* State::findClient(std::string_view address) const {
+  auto it = clients.find(std::string(address));
+  return it != clients.end() ? &it->second : nullptr;
+}
+
+Json::Value State::clientsJson(int workspaceId) const {
+  Json::Value json(Json::arrayValue);
+  const auto* ws = findWorkspace(workspaceId);
+  for (const auto& [address, client] : clients) {
+    if (client.workspaceId != workspaceId) {
+      continue;
+    }
+    Json::Value value;
+    value["address"] = "0x" + address;
+    value["workspace"]["id"] = workspaceId;
+    value["workspace"]["name"] = ws != nullptr ? ws->name : "";
+    value["class"] = client.className;
+    value["initialClass"] = client.initialClass;
+    value["title"] = client.title;
+    value["initialTitle"] = client.initialTitle;
+    value["floating"] = client.floating;
+    value["fullscreen"] = client.fullscreen ? 1 : 0;
+    value["mapped"] = client.mapped;
+    value["hidden"] = client.hidden;
+    json.append(std::move(value));
+  }
+  return json;
+}
+
+State::Monitor* State::monitor(std::string_view name) {
+  return const_cast<Monitor*>(findMonitor(name));
+}
+
+State::Workspace* State::workspace(std::string_view name) {
+  return const_cast<Workspace*>(findWorkspace(name));
+}
+
+bool State::activate(int id) {
+  auto ws = workspaces.find(id);
+  if (ws == workspaces.end()) {
+    return false;
+  }
+  auto* mon = monitor(ws->second.monitor);
+  if (mon == nullptr) {
+    return false;
+  }
+  for (auto& other : monitors) {
+    other.focused = &other == mon;
+  }
+  mon->activeWorkspaceId = id;
+  return true;
+}
+
+void State::refresh(int id) {
+  auto ws = workspaces.find(id);
+  if (ws == workspaces.end()) {
+    return;
+  }
+  ws->second.windows = 0;
+  ws->second.hasFullscreen = false;
+  for (const auto& [address, client] : clients) {
+    if (client.workspaceId == id && client.mapped) {
+      ws->second.windows++;
+      ws->second.hasFullscreen = ws->second.hasFullscreen || client.fullscreen;
+    }
+  }
+}
+
+}  // namespace waybar::modules::hyprland
@@ -19,7 +19,7 @@ Submap::Submap(const std::string& id, const Bar& bar, const Json::Value& config)
   // Needs an actual way to retrieve current submap on startup
   if (always_on_) {
     submap_ = default_submap_;
-    label_.get_style_context()->add_class(submap_);
+    label_.add_class(submap_);
   }
 
   // register for hyprland ipc
@@ -71,7 +71,7 @@ void Submap::onEvent(const std::string& ev) {
   auto submapName = ev.substr(ev.find_first_of('>') + 2);
 
   if (!submap_.empty()) {
-    label_.get_style_context()->remove_class(submap_);
+    label_.remove_class(submap_);
   }
 
   submap_ = submapName;
@@ -80,7 +80,7 @@ void Submap::onEvent(const std::string& ev) {
     submap_ = default_submap_;
   }
 
-  label_.get_style_context()->add_class(submap_);
+  label_.add_class(submap_);
 
   spdlog::debug("hyprland submap onevent with {}", submap_);
 
@@ -110,21 +110,21 @@ auto Window::update() -> void {
 }
 
 auto Window::getActiveWorkspace() -> Workspace {
-  const auto workspace = IPC::inst().getSocket1JsonReply("activeworkspace");
+  const auto workspace = IPC::inst().getSocket1JsonReplyShared("activeworkspace");
 
-  if (workspace.isObject()) {
-    return Workspace::parse(workspace);
+  if (workspace->isObject()) {
+    return Workspace::parse(*workspace);
   }
 
   return {};
 }
 
 auto Window::getActiveWorkspace(const std::string& monitorName) -> Workspace {
-  const auto monitors = IPC::inst().getSocket1JsonReply("monitors");
-  if (monitors.isArray()) {
+  const auto monitors = IPC::inst().getSocket1JsonReplyShared("monitors");
+  if (monitors->isArray()) {
     auto monitor = std::ranges::find_if(
-        monitors, [&](Json::Value monitor) { return monitor["name"] == monitorName; });
-    if (monitor == std::end(monitors)) {
+        *monitors, [&](const Json::Value& monitor) { return monitor["name"] == monitorName; });
+    if (monitor == std::end(*monitors)) {
       spdlog::warn("Monitor not found: {}", monitorName);
       return Workspace{
           .id = -1,
@@ -135,11 +135,11 @@ auto Window::getActiveWorkspace(const std::string& monitorName) -> Workspace {
     }
     const int id = (*monitor)["activeWorkspace"]["id"].asInt();
 
-    const auto workspaces = IPC::inst().getSocket1JsonReply("workspaces");
-    if (workspaces.isArray()) {
+    const auto workspaces = IPC::inst().getSocket1JsonReplyShared("workspaces");
+    if (workspaces->isArray()) {
       auto workspace = std::ranges::find_if(
-          workspaces, [&](Json::Value workspace) { return workspace["id"] == id; });
-      if (workspace == std::end(workspaces)) {
+          *workspaces, [&](const Json::Value& workspace) { return workspace["id"] == id; });
+      if (workspace == std::end(*workspaces)) {
         spdlog::warn("No workspace with id {}", id);
         return Workspace{
             .id = -1,
@@ -186,12 +186,13 @@ void Window::queryActiveWorkspace() {
 
   focused_ = true;
   if (workspace_.windows > 0) {
-    const auto clients = m_ipc.getSocket1JsonReply("clients");
-    if (clients.isArray()) {
-      auto activeWindow = std::ranges::find_if(
-          clients, [&](Json::Value window) { return window["address"] == workspace_.last_window; });
+    const auto clients = m_ipc.getSocket1JsonReplyShared("clients");
+    if (clients->isArray()) {
+      auto activeWindow = std::ranges::find_if(*clients, [&](const Json::Value& window) {
+        return window["address"] == workspace_.last_window;
+      });
 
-      if (activeWindow == std::end(clients)) {
+      if (activeWindow == std::end(*clients)) {
         focused_ = false;
         return;
       }
@@ -199,9 +200,11 @@ void Window::queryActiveWorkspace() {
       windowData_ = WindowData::parse(*activeWindow);
       updateAppIconName(windowData_.class_name, windowData_.initial_class_name);
       std::vector<Json::Value> workspaceWindows;
-      std::ranges::copy_if(clients, std::back_inserter(workspaceWindows), [&](Json::Value window) {
-        return window["workspace"]["id"] == workspace_.id && window["mapped"].asBool();
-      });
+      std::ranges::copy_if(*clients, std::back_inserter(workspaceWindows),
+                           [&](const Json::Value& window) {
+                             return window["workspace"]["id"] == workspace_.id &&
+                                    window["mapped"].asBool();
+                           });
       swallowing_ = std::ranges::any_of(workspaceWindows, [&](Json::Value window) {
         return !window["swallowing"].isNull() && window["swallowing"].asString() != "0x0";
       });
@@ -70,48 +70,29 @@ auto WindowCount::update() -> void {
 }
 
 auto WindowCount::getActiveWorkspace() -> Workspace {
-  const auto workspace = gIPC->getSocket1JsonReply("activeworkspace");
-
-  if (workspace.isObject()) {
-    return Workspace::parse(workspace);
+  const auto state = gIPC->getState();
+  if (const auto* monitor = state->focusedMonitor()) {
+    if (const auto* workspace = state->findWorkspace(monitor->activeWorkspaceId)) {
+      return Workspace{workspace->id, workspace->windows, workspace->hasFullscreen};
+    }
   }
 
   return {};
 }
 
 auto WindowCount::getActiveWorkspace(const std::string& monitorName) -> Workspace {
-  const auto monitors = gIPC->getSocket1JsonReply("monitors");
-  if (monitors.isArray()) {
-    auto monitor = std::find_if(monitors.begin(), monitors.end(), [&](Json::Value monitor) {
-      return monitor["name"] == monitorName;
-    });
-    if (monitor == std::end(monitors)) {
-      spdlog::warn("Monitor not found: {}", monitorName);
-      return Workspace{-1, 0, false};
-    }
-    const int id = (*monitor)["activeWorkspace"]["id"].asInt();
-
-    const auto workspaces = gIPC->getSocket1JsonReply("workspaces");
-    if (workspaces.isArray()) {
-      auto workspace = std::find_if(workspaces.begin(), workspaces.end(),
-                                    [&](Json::Value workspace) { return workspace["id"] == id; });
-      if (workspace == std::end(workspaces)) {
-        spdlog::warn("No workspace with id {}", id);
-        return Workspace{-1, 0, false};
-      }
-      return Workspace::parse(*workspace);
-    };
-  };
-
-  return {};
-}
-
-auto WindowCount::Workspace::parse(const Json::Value& value) -> WindowCount::Workspace {
-  return Workspace{
-      value["id"].asInt(),
-      value["windows"].asInt(),
-      value["hasfullscreen"].asBool(),
-  };
+  const auto state = gIPC->getState();
+  const auto* monitor = state->findMonitor(monitorName);
+  if (monitor == nullptr) {
+    spdlog::warn("Monitor not found: {}", monitorName);
+    return Workspace{-1, 0, false};
+  }
+  const auto* workspace = state->findWorkspace(monitor->activeWorkspaceId);
+  if (workspace == nullptr) {
+    spdlog::warn("No workspace with id {}", monitor->activeWorkspaceId);
+    return Workspace{-1, 0, false};
+  }
+  return Workspace{workspace->id, workspace->windows, workspace->hasFullscreen};
 }
 
 void WindowCount::queryActiveWorkspace() {
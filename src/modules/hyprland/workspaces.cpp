@@ -41,7 +41,7 @@ Workspaces::~Workspaces() {
 }
 
 void Workspaces::init() {
-  m_activeWorkspaceId = m_ipc.getSocket1JsonReply("activeworkspace")["id"].asInt();
+  m_activeWorkspaceId = (*m_ipc.getSocket1JsonReplyShared("activeworkspace"))["id"].asInt();
 
   initializeWorkspaces();
   dp.emit();
@@ -127,10 +127,12 @@ void Workspaces::createWorkspacesToCreate() {
 void Workspaces::doUpdate() {
   std::unique_lock lock(m_mutex);
 
+  const auto state = m_ipc.getState();
+
   removeWorkspacesToRemove();
   createWorkspacesToCreate();
-  updateWorkspaceStates();
-  updateWindowCount();
+  updateWorkspaceStates(*state);
+  updateWindowCount(*state);
   sortWorkspaces();
 
   bool anyWindowCreated = updateWindowsToCreate();
@@ -161,18 +163,12 @@ std::string Workspaces::getRewrite(std::string window_class, std::string window_
                      fmt::arg("title", window_title));
 }
 
-std::vector<int> Workspaces::getVisibleWorkspaces() {
+std::vector<int> Workspaces::getVisibleWorkspaces(const State &state) {
   std::vector<int> visibleWorkspaces;
-  auto monitors = IPC::inst().getSocket1JsonReply("monitors");
-  for (const auto &monitor : monitors) {
-    auto ws = monitor["activeWorkspace"];
-    if (ws.isObject() && ws["id"].isInt()) {
-      visibleWorkspaces.push_back(ws["id"].asInt());
-    }
-    auto sws = monitor["specialWorkspace"];
-    auto name = sws["name"].asString();
-    if (sws.isObject() && sws["id"].isInt() && !name.empty()) {
-      visibleWorkspaces.push_back(sws["id"].asInt());
+  for (const auto &monitor : state.monitors) {
+    visibleWorkspaces.push_back(monitor.activeWorkspaceId);
+    if (!monitor.specialWorkspaceName.empty()) {
+      visibleWorkspaces.push_back(monitor.specialWorkspaceId);
     }
   }
   return visibleWorkspaces;
@@ -187,8 +183,9 @@ void Workspaces::initializeWorkspaces() {
   }
 
   // get all current workspaces
-  auto const workspacesJson = m_ipc.getSocket1JsonReply("workspaces");
-  auto const clientsJson = m_ipc.getSocket1JsonReply("clients");
+  const auto replies = m_ipc.getSocket1JsonReplies({"workspaces", "clients"});
+  const auto &workspacesJson = *replies[0];
+  const auto &clientsJson = *replies[1];
 
   for (Json::Value workspaceJson : workspacesJson) {
     std::string workspaceName = workspaceJson["name"].asString();
@@ -386,8 +383,9 @@ void Workspaces::onWorkspaceCreated(std::string const &payload, Json::Value cons
     return;
   }
 
-  auto const workspaceRules = m_ipc.getSocket1JsonReply("workspacerules");
-  auto const workspacesJson = m_ipc.getSocket1JsonReply("workspaces");
+  const auto replies = m_ipc.getSocket1JsonReplies({"workspacerules", "workspaces"});
+  const auto &workspaceRules = *replies[0];
+  const auto &workspacesJson = *replies[1];
 
   for (Json::Value workspaceJson : workspacesJson) {
     const auto currentId = workspaceJson["id"].asInt();
@@ -426,7 +424,10 @@ void Workspaces::onWorkspaceMoved(std::string const &payload) {
   spdlog::debug("Workspace moved: {}", payload);
 
   // Update active workspace
-  m_activeWorkspaceId = (m_ipc.getSocket1JsonReply("activeworkspace"))["id"].asInt();
+  const auto state = m_ipc.getState();
+  if (const auto *focused = state->focusedMonitor()) {
+    m_activeWorkspaceId = focused->activeWorkspaceId;
+  }
 
   if (allOutputs()) return;
 
@@ -435,8 +436,8 @@ void Workspaces::onWorkspaceMoved(std::string const &payload) {
   const auto subPayload = makePayload(workspaceIdStr, workspaceName);
 
   if (m_bar.output->name == monitorName) {
-    Json::Value clientsData = m_ipc.getSocket1JsonReply("clients");
-    onWorkspaceCreated(subPayload, clientsData);
+    const auto workspaceId = parseWorkspaceId(workspaceIdStr);
+    onWorkspaceCreated(subPayload, state->clientsJson(workspaceId.value_or(0)));
   } else {
     spdlog::debug("Removing workspace because it was moved to another monitor: {}", subPayload);
     onWorkspaceDestroyed(subPayload);
@@ -583,15 +584,11 @@ void Workspaces::onWindowTitleEvent(std::string const &payload) {
   }
 
   if (inserter.has_value()) {
-    Json::Value clientsData = m_ipc.getSocket1JsonReply("clients");
-    std::string jsonWindowAddress = fmt::format("0x{}", windowAddress);
-
-    auto client = std::ranges::find_if(clientsData, [jsonWindowAddress](auto &client) {
-      return client["address"].asString() == jsonWindowAddress;
-    });
-
-    if (client != clientsData.end() && !client->empty()) {
-      (*inserter)({*client});
+    const auto state = m_ipc.getState();
+    if (const auto *client = state->findClient(windowAddress)) {
+      const auto *workspace = state->findWorkspace(client->workspaceId);
+      (*inserter)({workspace != nullptr ? workspace->name : "", client->address, client->className,
+                   client->title, false});
     }
   }
 }
@@ -874,11 +871,11 @@ void Workspaces::removeWorkspace(std::string const &workspaceString) {
 void Workspaces::setCurrentMonitorId() {
   // get monitor ID from name (used by persistent workspaces)
   m_monitorId = 0;
-  auto monitors = m_ipc.getSocket1JsonReply("monitors");
-  auto currentMonitor = std::ranges::find_if(monitors, [this](const Json::Value &m) {
+  const auto monitors = m_ipc.getSocket1JsonReplyShared("monitors");
+  auto currentMonitor = std::ranges::find_if(*monitors, [this](const Json::Value &m) {
     return m["name"].asString() == m_bar.output->name;
   });
-  if (currentMonitor == monitors.end()) {
+  if (currentMonitor == monitors->end()) {
     spdlog::error("Monitor '{}' does not have an ID? Using 0", m_bar.output->name);
   } else {
     m_monitorId = (*currentMonitor)["id"].asInt();
@@ -988,15 +985,9 @@ void Workspaces::sortWorkspaces() {
 }
 
 void Workspaces::setUrgentWorkspace(std::string const &windowaddress) {
-  const Json::Value clientsJson = m_ipc.getSocket1JsonReply("clients");
-  int workspaceId = -1;
-
-  for (Json::Value clientJson : clientsJson) {
-    if (clientJson["address"].asString().ends_with(windowaddress)) {
-      workspaceId = clientJson["workspace"]["id"].asInt();
-      break;
-    }
-  }
+  const auto state = m_ipc.getState();
+  const auto *client = state->findClient(windowaddress);
+  int workspaceId = client != nullptr ? client->workspaceId : -1;
 
   auto workspace = std::ranges::find_if(m_workspaces, [workspaceId](std::unique_ptr<Workspace> &x) {
     return x->id() == workspaceId;
@@ -1011,22 +1002,15 @@ auto Workspaces::update() -> void {
   AModule::update();
 }
 
-void Workspaces::updateWindowCount() {
-  const Json::Value workspacesJson = m_ipc.getSocket1JsonReply("workspaces");
+void Workspaces::updateWindowCount() { updateWindowCount(*m_ipc.getState()); }
+
+void Workspaces::updateWindowCount(const State &state) {
   for (auto const &workspace : m_workspaces) {
-    auto workspaceJson = std::ranges::find_if(workspacesJson, [&](Json::Value const &x) {
-      return x["name"].asString() == workspace->name() ||
-             (workspace->isSpecial() && x["name"].asString() == "special:" + workspace->name());
-    });
-    uint32_t count = 0;
-    if (workspaceJson != workspacesJson.end()) {
-      try {
-        count = (*workspaceJson)["windows"].asUInt();
-      } catch (const std::exception &e) {
-        spdlog::error("Failed to update window count: {}", e.what());
-      }
+    const auto *stateWorkspace = state.findWorkspace(workspace->name());
+    if (stateWorkspace == nullptr && workspace->isSpecial()) {
+      stateWorkspace = state.findWorkspace("special:" + workspace->name());
     }
-    workspace->setWindows(count);
+    workspace->setWindows(stateWorkspace != nullptr ? std::max(stateWorkspace->windows, 0) : 0);
   }
 }
 
@@ -1056,13 +1040,12 @@ bool Workspaces::updateWindowsToCreate() {
   return anyWindowCreated;
 }
 
-void Workspaces::updateWorkspaceStates() {
-  const std::vector<int> visibleWorkspaces = getVisibleWorkspaces();
-  auto updatedWorkspaces = m_ipc.getSocket1JsonReply("workspaces");
-
-  auto currentWorkspace = m_ipc.getSocket1JsonReply("activeworkspace");
-  std::string currentWorkspaceName =
-      currentWorkspace.isMember("name") ? currentWorkspace["name"].asString() : "";
+void Workspaces::updateWorkspaceStates(const State &state) {
+  const std::vector<int> visibleWorkspaces = getVisibleWorkspaces(state);
+  const auto *focusedMonitor = state.focusedMonitor();
+  const auto *currentWorkspace =
+      focusedMonitor != nullptr ? state.findWorkspace(focusedMonitor->activeWorkspaceId) : nullptr;
+  std::string currentWorkspaceName = currentWorkspace != nullptr ? currentWorkspace->name : "";
 
   for (auto &workspace : m_workspaces) {
     bool isActiveByName =
@@ -1080,13 +1063,13 @@ void Workspaces::updateWorkspaceStates() {
     if (m_withIcon) {
       workspaceIcon = workspace->selectIcon(m_iconsMap);
     }
-    auto updatedWorkspace = std::ranges::find_if(updatedWorkspaces, [&workspace](const auto &w) {
-      auto wNameRaw = w["name"].asString();
+    auto updatedWorkspace = std::ranges::find_if(state.workspaces, [&workspace](const auto &w) {
+      const auto &wNameRaw = w.second.name;
       auto wName = wNameRaw.starts_with("special:") ? wNameRaw.substr(8) : wNameRaw;
       return wName == workspace->name();
     });
-    if (updatedWorkspace != updatedWorkspaces.end()) {
-      workspace->setOutput((*updatedWorkspace)["monitor"].asString());
+    if (updatedWorkspace != state.workspaces.end()) {
+      workspace->setOutput(updatedWorkspace->second.monitor);
     }
     workspace->update(workspaceIcon);
   }
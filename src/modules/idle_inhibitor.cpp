@@ -49,13 +49,13 @@ waybar::modules::IdleInhibitor::~IdleInhibitor() {
 auto waybar::modules::IdleInhibitor::update() -> void {
   // Check status
   if (status) {
-    label_.get_style_context()->remove_class("deactivated");
+    label_.remove_class("deactivated");
     if (idle_inhibitor_ == nullptr) {
       idle_inhibitor_ = zwp_idle_inhibit_manager_v1_create_inhibitor(
           waybar::Client::inst()->idle_inhibit_manager, bar_.surface);
     }
   } else {
-    label_.get_style_context()->remove_class("activated");
+    label_.remove_class("activated");
     if (idle_inhibitor_ != nullptr) {
       zwp_idle_inhibitor_v1_destroy(idle_inhibitor_);
       idle_inhibitor_ = nullptr;
@@ -65,7 +65,7 @@ auto waybar::modules::IdleInhibitor::update() -> void {
   std::string status_text = status ? "activated" : "deactivated";
   label_.set_markup(fmt::format(fmt::runtime(format_), fmt::arg("status", status_text),
                                 fmt::arg("icon", getIcon(0, status_text))));
-  label_.get_style_context()->add_class(status_text);
+  label_.add_class(status_text);
   if (tooltipEnabled()) {
     auto config = config_[status ? "tooltip-format-activated" : "tooltip-format-deactivated"];
     auto tooltip_format = config.isString() ? config.asString() : "{status}";
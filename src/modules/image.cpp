@@ -1,5 +1,61 @@
 #include "modules/image.hpp"
 
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace {
+
+/**
+ * Decoded images shared by every image module, so that the same file shown on several bars is
+ * decoded once. Keeps the most recently used ones.
+ */
+class PixbufCache {
+ public:
+  static PixbufCache& inst() {
+    static auto* inst = new PixbufCache();
+    return *inst;
+  }
+
+  Glib::RefPtr<Gdk::Pixbuf> get(const waybar::modules::Image::Key& key) {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return {};
+    }
+    it->second.used = ++clock_;
+    return it->second.pixbuf;
+  }
+
+  void put(const waybar::modules::Image::Key& key, const Glib::RefPtr<Gdk::Pixbuf>& pixbuf) {
+    std::lock_guard lock(mutex_);
+    entries_[key] = {pixbuf, ++clock_};
+    if (entries_.size() > CAPACITY) {
+      auto oldest = std::min_element(entries_.begin(), entries_.end(), [](auto& a, auto& b) {
+        return a.second.used < b.second.used;
+      });
+      entries_.erase(oldest);
+    }
+  }
+
+ private:
+  static constexpr size_t CAPACITY = 32;
+
+  struct Entry {
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+    uint64_t used;
+  };
+
+  std::mutex mutex_;
+  uint64_t clock_ = 0;
+  std::map<waybar::modules::Image::Key, Entry> entries_;
+};
+
+}  // namespace
+
 waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
     : AModule(config, "image", id), box_(Gtk::ORIENTATION_HORIZONTAL, 0) {
   box_.pack_start(image_);
@@ -10,8 +66,6 @@ waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
   box_.get_style_context()->add_class(MODULE_CLASS);
   event_box_.add(box_);
 
-  dp.emit();
-
   size_ = config["size"].asInt();
 
   if (config_["interval"].isString() && config_["interval"].asString() == "once") {
@@ -31,15 +85,56 @@ waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
   if (size_ == 0) {
     size_ = 16;
   }
+  scale_ = image_.get_scale_factor();
+  image_.property_scale_factor().signal_changed().connect([this] { dp.emit(); });
 
   delayWorker();
 }
 
 void waybar::modules::Image::delayWorker() {
   thread_ = [this] {
+    auto [path, tooltip] = source();
+    Frame frame;
+    frame.key = {std::move(path), 0, size_, scale_};
+    frame.tooltip = std::move(tooltip);
+    struct stat st;
+    if (!frame.key.path.empty() && stat(frame.key.path.c_str(), &st) == 0) {
+      frame.key.mtime_ns =
+          static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    } else {
+      frame.key.path.clear();
+    }
+
+    // Unchanged, costs the stat() above and nothing on the main loop
+    if (published_ && published_->first == frame.key && published_->second == frame.tooltip) {
+      thread_.sleep();
+      return;
+    }
+    published_.emplace(frame.key, frame.tooltip);
+
+    if (!frame.key.path.empty()) {
+      frame.pixbuf = PixbufCache::inst().get(frame.key);
+      if (!frame.pixbuf) {
+        try {
+          int scaled_icon_size = frame.key.size * frame.key.scale;
+          frame.pixbuf =
+              Gdk::Pixbuf::create_from_file(frame.key.path, scaled_icon_size, scaled_icon_size);
+          PixbufCache::inst().put(frame.key, frame.pixbuf);
+        } catch (const Glib::Error& e) {
+          spdlog::error("image: unable to load {}: {}", frame.key.path, e.what().c_str());
+        }
+      }
+    }
+    {
+      std::lock_guard lock(frame_mutex_);
+      pending_ = std::move(frame);
+    }
     dp.emit();
-    thread_.sleep_for(interval_);
+    thread_.sleep();
   };
+  // The worker runs the commands and decodes, the shared scheduler only provides the wakeups
+  timer_ = util::Scheduler::inst().schedule(
+      interval_, [this] { thread_.wake_up(); }, false);
 }
 
 void waybar::modules::Image::refresh(int sig) {
@@ -48,55 +143,55 @@ void waybar::modules::Image::refresh(int sig) {
   }
 }
 
-auto waybar::modules::Image::update() -> void {
+std::pair<std::string, std::string> waybar::modules::Image::source() {
   if (config_["path"].isString()) {
-    path_ = config_["path"].asString();
-  } else if (config_["exec"].isString()) {
-    output_ = util::command::exec(config_["exec"].asString(), "");
-    parseOutputRaw();
-  } else {
-    path_ = "";
+    return {config_["path"].asString(), ""};
   }
+  if (!config_["exec"].isString()) {
+    return {};
+  }
+  auto output = util::command::exec(config_["exec"].asString(), "");
+  std::istringstream stream(output.out);
+  std::string path;
+  std::string tooltip;
+  getline(stream, path);
+  getline(stream, tooltip);
+  return {path, tooltip};
+}
 
-  if (Glib::file_test(path_, Glib::FILE_TEST_EXISTS)) {
-    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
-
-    int scaled_icon_size = size_ * image_.get_scale_factor();
-    pixbuf = Gdk::Pixbuf::create_from_file(path_, scaled_icon_size, scaled_icon_size);
-
-    auto surface = Gdk::Cairo::create_surface_from_pixbuf(pixbuf, image_.get_scale_factor(),
-                                                          image_.get_window());
-    image_.set(surface);
-    image_.show();
+auto waybar::modules::Image::update() -> void {
+  std::optional<Frame> frame;
+  {
+    std::lock_guard lock(frame_mutex_);
+    frame.swap(pending_);
+  }
 
-    if (tooltipEnabled() && !tooltip_.empty()) {
-      if (box_.get_tooltip_markup() != tooltip_) {
-        box_.set_tooltip_markup(tooltip_);
+  if (frame) {
+    if (frame->pixbuf) {
+      auto surface = Gdk::Cairo::create_surface_from_pixbuf(frame->pixbuf, frame->key.scale,
+                                                            image_.get_window());
+      image_.set(surface);
+      image_.show();
+
+      if (tooltipEnabled() && !frame->tooltip.empty()) {
+        if (box_.get_tooltip_markup() != frame->tooltip) {
+          box_.set_tooltip_markup(frame->tooltip);
+        }
       }
+
+      box_.get_style_context()->remove_class("empty");
+    } else {
+      image_.clear();
+      image_.hide();
+      box_.get_style_context()->add_class("empty");
     }
+  }
 
-    box_.get_style_context()->remove_class("empty");
-  } else {
-    image_.clear();
-    image_.hide();
-    box_.get_style_context()->add_class("empty");
+  // Decoded again at the new scale, e.g. once the bar is mapped on a HiDPI output
+  if (image_.get_scale_factor() != scale_) {
+    scale_ = image_.get_scale_factor();
+    thread_.wake_up();
   }
 
   AModule::update();
 }
-
-void waybar::modules::Image::parseOutputRaw() {
-  std::istringstream output(output_.out);
-  std::string line;
-  int i = 0;
-  while (getline(output, line)) {
-    if (i == 0) {
-      path_ = line;
-    } else if (i == 1) {
-      tooltip_ = line;
-    } else {
-      break;
-    }
-    i++;
-  }
-}
@@ -7,10 +7,7 @@ JACK::JACK(const std::string &id, const Json::Value &config)
   running_ = false;
   client_ = NULL;
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  timer_ = util::Scheduler::inst().schedule(interval_, [this] { dp.emit(); });
 }
 
 std::string JACK::JACKState() {
@@ -56,13 +53,13 @@ auto JACK::update() -> void {
   float latency = 1000 * (float)bufsize_ / (float)samplerate_;
 
   if (label_.get_style_context()->has_class("xrun")) {
-    label_.get_style_context()->remove_class("xrun");
+    label_.remove_class("xrun");
     state = "connected";
   }
 
   if (label_.get_style_context()->has_class(state_))
-    label_.get_style_context()->remove_class(state_);
-  label_.get_style_context()->add_class(state);
+    label_.remove_class(state_);
+  label_.add_class(state);
   state_ = state;
 
   if (config_["format-" + state].isString()) {
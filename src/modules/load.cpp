@@ -1,25 +1,29 @@
 #include "modules/load.hpp"
 
-// In the 80000 version of fmt library authors decided to optimize imports
-// and moved declarations required for fmt::dynamic_format_arg_store in new
-// header fmt/args.h
-#if (FMT_VERSION >= 80000)
-#include <fmt/args.h>
-#else
-#include <fmt/core.h>
-#endif
+#include <algorithm>
 
 waybar::modules::Load::Load(const std::string& id, const Json::Value& config)
     : ALabel(config, "load", id, "{load1}", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  sampler_ =
+      util::SystemSampler::inst().subscribe(interval_, {util::SystemSampler::LOADAVG}, &dp);
 }
 
+waybar::modules::Load::~Load() { sampler_.reset(); }
+
 auto waybar::modules::Load::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto [load1, load5, load15] = Load::getLoad();
+  auto snapshot = sampler_.snapshot();
+  // No load average if getloadavg() failed
+  if (!snapshot || !snapshot->loadavg) {
+    return;
+  }
+  // Neither the load nor the format (format-alt) changed since the last render
+  if (!snapshot->changedSince(util::SystemSampler::LOADAVG, rendered_version_) &&
+      format_ == rendered_format_) {
+    return;
+  }
+  rendered_version_ = snapshot->version;
+  rendered_format_ = format_;
+  auto [load1, load5, load15] = getLoad(*snapshot->loadavg);
   if (tooltipEnabled()) {
     auto tooltip = fmt::format("Load 1: {}\nLoad 5: {}\nLoad 15: {}", load1, load5, load15);
     label_.set_tooltip_text(tooltip);
@@ -35,27 +39,34 @@ auto waybar::modules::Load::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
-    fmt::dynamic_format_arg_store<fmt::format_context> store;
-    store.push_back(fmt::arg("load1", load1));
-    store.push_back(fmt::arg("load5", load5));
-    store.push_back(fmt::arg("load15", load15));
-    store.push_back(fmt::arg("icon1", getIcon(load1, icons)));
-    store.push_back(fmt::arg("icon5", getIcon(load5, icons)));
-    store.push_back(fmt::arg("icon15", getIcon(load15, icons)));
-    label_.set_markup(fmt::vformat(format, store));
+    const std::array<double, 3> loads = {load1, load5, load15};
+    // Slot 0-2 is a load average, 3-5 its icon
+    auto bind = [](std::string_view name, size_t&) -> int {
+      static constexpr std::array<std::string_view, 6> names = {"load1", "load5", "load15",
+                                                                "icon1", "icon5", "icon15"};
+      auto it = std::ranges::find(names, name);
+      return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+    };
+    formatTemplate(format, bind)
+        .render(markup_, [&](const util::FormatTemplate::Field& field, std::string& out) {
+          if (field.slot < 0) {
+            util::FormatTemplate::unknownField(field);
+          } else if (field.slot < 3) {
+            field.append(out, loads[field.slot]);
+          } else {
+            field.append(out, getIcon(loads[field.slot - 3], icons));
+          }
+        });
+    label_.set_markup(markup_);
   }
 
   // Call parent update
   ALabel::update();
 }
 
-std::tuple<double, double, double> waybar::modules::Load::getLoad() {
-  double load[3];
-  if (getloadavg(load, 3) != -1) {
-    double load1 = std::ceil(load[0] * 100.0) / 100.0;
-    double load5 = std::ceil(load[1] * 100.0) / 100.0;
-    double load15 = std::ceil(load[2] * 100.0) / 100.0;
-    return {load1, load5, load15};
-  }
-  throw std::runtime_error("Can't get system load");
+waybar::modules::Load::Sample waybar::modules::Load::getLoad(const std::array<double, 3>& load) {
+  double load1 = std::ceil(load[0] * 100.0) / 100.0;
+  double load5 = std::ceil(load[1] * 100.0) / 100.0;
+  double load15 = std::ceil(load[2] * 100.0) / 100.0;
+  return {load1, load5, load15};
 }
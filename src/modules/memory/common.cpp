@@ -2,32 +2,41 @@
 
 waybar::modules::Memory::Memory(const std::string& id, const Json::Value& config)
     : ALabel(config, "memory", id, "{}%", 30) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  util::SystemSampler::Request request;
+  request.fields = util::SystemSampler::MEMINFO;
+  request.read_meminfo = &Memory::parseMeminfo;
+  sampler_ = util::SystemSampler::inst().subscribe(interval_, std::move(request), &dp);
 }
 
 auto waybar::modules::Memory::update() -> void {
-  parseMeminfo();
-
-  unsigned long memtotal = meminfo_["MemTotal"];
-  unsigned long swaptotal = 0;
-  if (meminfo_.count("SwapTotal")) {
-    swaptotal = meminfo_["SwapTotal"];
+  auto snapshot = sampler_.snapshot();
+  if (!snapshot) {
+    return;
   }
-  unsigned long memfree;
-  unsigned long swapfree = 0;
-  if (meminfo_.count("SwapFree")) {
-    swapfree = meminfo_["SwapFree"];
+  // Neither the counters nor the format (format-alt) changed since the last render
+  if (!snapshot->changedSince(util::SystemSampler::MEMINFO, rendered_version_) &&
+      format_ == rendered_format_) {
+    return;
   }
-  if (meminfo_.count("MemAvailable")) {
+  rendered_version_ = snapshot->version;
+  rendered_format_ = format_;
+
+  const auto& meminfo = snapshot->meminfo;
+  auto get = [&meminfo](const std::string& name) -> unsigned long {
+    auto it = meminfo.find(name);
+    return it == meminfo.end() ? 0 : it->second;
+  };
+  unsigned long memtotal = get("MemTotal");
+  unsigned long swaptotal = get("SwapTotal");
+  unsigned long memfree;
+  unsigned long swapfree = get("SwapFree");
+  if (meminfo.contains("MemAvailable")) {
     // New kernels (3.4+) have an accurate available memory field.
-    memfree = meminfo_["MemAvailable"] + meminfo_["zfs_size"];
+    memfree = get("MemAvailable") + get("zfs_size");
   } else {
     // Old kernel; give a best-effort approximation of available memory.
-    memfree = meminfo_["MemFree"] + meminfo_["Buffers"] + meminfo_["Cached"] +
-              meminfo_["SReclaimable"] - meminfo_["Shmem"] + meminfo_["zfs_size"];
+    memfree = get("MemFree") + get("Buffers") + get("Cached") + get("SReclaimable") -
+              get("Shmem") + get("zfs_size");
   }
 
   if (memtotal > 0 && memfree >= 0) {
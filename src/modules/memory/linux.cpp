@@ -21,7 +21,7 @@ static unsigned zfsArcSize() {
   return 0;
 }
 
-void waybar::modules::Memory::parseMeminfo() {
+void waybar::modules::Memory::parseMeminfo(util::SystemSampler::Meminfo& meminfo) {
   const std::string data_dir_ = "/proc/meminfo";
   std::ifstream info(data_dir_);
   if (!info.is_open()) {
@@ -36,8 +36,8 @@ void waybar::modules::Memory::parseMeminfo() {
 
     std::string name = line.substr(0, posDelim);
     int64_t value = std::stol(line.substr(posDelim + 1));
-    meminfo_[name] = value;
+    meminfo[name] = value;
   }
 
-  meminfo_["zfs_size"] = zfsArcSize();
+  meminfo["zfs_size"] = zfsArcSize();
 }
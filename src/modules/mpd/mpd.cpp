@@ -89,10 +89,10 @@ std::string waybar::modules::MPD::getFilename() const {
 
 void waybar::modules::MPD::setLabel() {
   if (connection_ == nullptr) {
-    label_.get_style_context()->add_class("disconnected");
-    label_.get_style_context()->remove_class("stopped");
-    label_.get_style_context()->remove_class("playing");
-    label_.get_style_context()->remove_class("paused");
+    label_.add_class("disconnected");
+    label_.remove_class("stopped");
+    label_.remove_class("playing");
+    label_.remove_class("paused");
 
     auto format = config_["format-disconnected"].isString()
                       ? config_["format-disconnected"].asString()
@@ -114,7 +114,7 @@ void waybar::modules::MPD::setLabel() {
     }
     return;
   }
-  label_.get_style_context()->remove_class("disconnected");
+  label_.remove_class("disconnected");
 
   auto format = format_;
   Glib::ustring artist, album_artist, album, title;
@@ -128,19 +128,19 @@ void waybar::modules::MPD::setLabel() {
     if (no_song) spdlog::warn("Bug in mpd: no current song but state is not stopped.");
     format =
         config_["format-stopped"].isString() ? config_["format-stopped"].asString() : "stopped";
-    label_.get_style_context()->add_class("stopped");
-    label_.get_style_context()->remove_class("playing");
-    label_.get_style_context()->remove_class("paused");
+    label_.add_class("stopped");
+    label_.remove_class("playing");
+    label_.remove_class("paused");
   } else {
-    label_.get_style_context()->remove_class("stopped");
+    label_.remove_class("stopped");
     if (playing()) {
-      label_.get_style_context()->add_class("playing");
-      label_.get_style_context()->remove_class("paused");
+      label_.add_class("playing");
+      label_.remove_class("paused");
     } else if (paused()) {
       format = config_["format-paused"].isString() ? config_["format-paused"].asString()
                                                    : config_["format"].asString();
-      label_.get_style_context()->add_class("paused");
-      label_.get_style_context()->remove_class("playing");
+      label_.add_class("paused");
+      label_.remove_class("playing");
     }
 
     stateIcon = getStateIcon();
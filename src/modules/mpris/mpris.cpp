@@ -657,19 +657,19 @@ auto Mpris::update() -> void {
 
   // set css class for player status
   if (!lastStatus.empty() && label_.get_style_context()->has_class(lastStatus)) {
-    label_.get_style_context()->remove_class(lastStatus);
+    label_.remove_class(lastStatus);
   }
   if (!label_.get_style_context()->has_class(info.status_string)) {
-    label_.get_style_context()->add_class(info.status_string);
+    label_.add_class(info.status_string);
   }
   lastStatus = info.status_string;
 
   // set css class for player name
   if (!lastPlayer.empty() && label_.get_style_context()->has_class(lastPlayer)) {
-    label_.get_style_context()->remove_class(lastPlayer);
+    label_.remove_class(lastPlayer);
   }
   if (!label_.get_style_context()->has_class(info.name)) {
-    label_.get_style_context()->add_class(info.name);
+    label_.add_class(info.name);
   }
   lastPlayer = info.name;
 
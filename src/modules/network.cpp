@@ -24,62 +24,13 @@ using namespace waybar::util;
 constexpr const char *DEFAULT_FORMAT = "{ifname}";
 }  // namespace
 
-constexpr const char *NETDEV_FILE =
-    "/proc/net/dev";  // std::ifstream does not take std::string_view as param
 std::optional<std::pair<unsigned long long, unsigned long long>>
-waybar::modules::Network::readBandwidthUsage() {
-  std::ifstream netdev(NETDEV_FILE);
-  if (!netdev) {
-    spdlog::warn("Failed to open netdev file {}", NETDEV_FILE);
+waybar::modules::Network::readBandwidthUsage(const util::SystemSampler::Snapshot &snapshot) const {
+  auto it = snapshot.netdev.find(ifname_);
+  if (it == snapshot.netdev.end()) {
     return {};
   }
-
-  std::string line;
-  // skip the headers (first two lines)
-  std::getline(netdev, line);
-  std::getline(netdev, line);
-
-  unsigned long long receivedBytes = 0ull;
-  unsigned long long transmittedBytes = 0ull;
-  while (std::getline(netdev, line)) {
-    std::istringstream iss(line);
-
-    std::string ifacename;
-    iss >> ifacename;      // ifacename contains "eth0:"
-    ifacename.pop_back();  // remove trailing ':'
-    if (ifacename != ifname_) {
-      continue;
-    }
-
-    // The rest of the line consists of whitespace separated counts divided
-    // into two groups (receive and transmit). Each group has the following
-    // columns: bytes, packets, errs, drop, fifo, frame, compressed, multicast
-    //
-    // We only care about the bytes count, so we'll just ignore the 7 other
-    // columns.
-    unsigned long long r = 0ull;
-    unsigned long long t = 0ull;
-    // Read received bytes
-    iss >> r;
-    // Skip all the other columns in the received group
-    for (int colsToSkip = 7; colsToSkip > 0; colsToSkip--) {
-      // skip whitespace between columns
-      while (iss.peek() == ' ') {
-        iss.ignore();
-      }
-      // skip the irrelevant column
-      while (iss.peek() != ' ') {
-        iss.ignore();
-      }
-    }
-    // Read transmit bytes
-    iss >> t;
-
-    receivedBytes += r;
-    transmittedBytes += t;
-  }
-
-  return {{receivedBytes, transmittedBytes}};
+  return {{it->second.received, it->second.transmitted}};
 }
 
 waybar::modules::Network::Network(const std::string &id, const Json::Value &config)
@@ -96,14 +47,9 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
     addr_pref_ = IPV4_6;
   }
 
-  auto bandwidth = readBandwidthUsage();
-  if (bandwidth.has_value()) {
-    bandwidth_down_total_ = (*bandwidth).first;
-    bandwidth_up_total_ = (*bandwidth).second;
-  } else {
-    bandwidth_down_total_ = 0;
-    bandwidth_up_total_ = 0;
-  }
+  // /proc/net/dev is read by the system sampler, update() is driven by the worker
+  sampler_ =
+      util::SystemSampler::inst().subscribe(interval_, {util::SystemSampler::NETDEV}, nullptr);
 
   if (!config_["interface"].isString()) {
     // "interface" isn't configured, then try to guess the external
@@ -277,24 +223,34 @@ auto waybar::modules::Network::update() -> void {
   std::lock_guard<std::mutex> lock(mutex_);
   std::string tooltip_format;
 
-  auto bandwidth = readBandwidthUsage();
-  auto bandwidth_down = 0ull;
-  auto bandwidth_up = 0ull;
-  if (bandwidth.has_value()) {
-    auto down_octets = (*bandwidth).first;
-    auto up_octets = (*bandwidth).second;
-
-    bandwidth_down = down_octets - bandwidth_down_total_;
-    bandwidth_down_total_ = down_octets;
-
-    bandwidth_up = up_octets - bandwidth_up_total_;
-    bandwidth_up_total_ = up_octets;
+  // Counters only move with a new snapshot, updates from netlink events reuse the last delta
+  auto snapshot = sampler_.snapshot();
+  if (snapshot && snapshot->version != bandwidth_version_) {
+    auto bandwidth = readBandwidthUsage(*snapshot);
+    bandwidth_down_ = bandwidth_up_ = 0;
+    if (bandwidth.has_value()) {
+      auto down_octets = (*bandwidth).first;
+      auto up_octets = (*bandwidth).second;
+
+      // Over the time the counters moved, updates don't follow the sampler's ticks exactly
+      auto elapsed = std::chrono::duration<double>(snapshot->taken - bandwidth_taken_).count();
+      if (bandwidth_version_ != 0 && elapsed > 0) {
+        bandwidth_down_ = (down_octets - bandwidth_down_total_) / elapsed;
+        bandwidth_up_ = (up_octets - bandwidth_up_total_) / elapsed;
+      }
+      bandwidth_down_total_ = down_octets;
+      bandwidth_up_total_ = up_octets;
+    }
+    bandwidth_version_ = snapshot->version;
+    bandwidth_taken_ = snapshot->taken;
   }
+  auto bandwidth_down = bandwidth_down_;
+  auto bandwidth_up = bandwidth_up_;
 
   if (!alt_) {
     auto state = getNetworkState();
     if (!state_.empty() && label_.get_style_context()->has_class(state_)) {
-      label_.get_style_context()->remove_class(state_);
+      label_.remove_class(state_);
     }
     if (config_["format-" + state].isString()) {
       default_format_ = config_["format-" + state].asString();
@@ -307,7 +263,7 @@ auto waybar::modules::Network::update() -> void {
       tooltip_format = config_["tooltip-format-" + state].asString();
     }
     if (!label_.get_style_context()->has_class(state)) {
-      label_.get_style_context()->add_class(state);
+      label_.add_class(state);
     }
     format_ = default_format_;
     state_ = state;
@@ -333,18 +289,15 @@ auto waybar::modules::Network::update() -> void {
       fmt::arg("ipaddr", final_ipaddr_), fmt::arg("gwaddr", gwaddr_), fmt::arg("cidr", cidr_),
       fmt::arg("cidr6", cidr6_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
       fmt::arg("icon", getIcon(signal_strength_, state_)),
-      fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthTotalBits",
-               pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-      fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-      fmt::arg("bandwidthTotalOctets",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-      fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-      fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-      fmt::arg("bandwidthTotalBytes",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
+      fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull, "b/s")),
+      fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull, "b/s")),
+      fmt::arg("bandwidthTotalBits", pow_format((bandwidth_up + bandwidth_down) * 8ull, "b/s")),
+      fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down, "o/s")),
+      fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up, "o/s")),
+      fmt::arg("bandwidthTotalOctets", pow_format(bandwidth_up + bandwidth_down, "o/s")),
+      fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down, "B/s")),
+      fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up, "B/s")),
+      fmt::arg("bandwidthTotalBytes", pow_format(bandwidth_up + bandwidth_down, "B/s")));
   if (text.compare(label_.get_label()) != 0) {
     label_.set_markup(text);
     if (text.empty()) {
@@ -366,19 +319,15 @@ auto waybar::modules::Network::update() -> void {
           fmt::arg("ipaddr", final_ipaddr_), fmt::arg("gwaddr", gwaddr_), fmt::arg("cidr", cidr_),
           fmt::arg("cidr6", cidr6_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
           fmt::arg("icon", getIcon(signal_strength_, state_)),
-          fmt::arg("bandwidthDownBits",
-                   pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthTotalBits",
-                   pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-          fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-          fmt::arg("bandwidthTotalOctets",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-          fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-          fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-          fmt::arg("bandwidthTotalBytes",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
+          fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull, "b/s")),
+          fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull, "b/s")),
+          fmt::arg("bandwidthTotalBits", pow_format((bandwidth_up + bandwidth_down) * 8ull, "b/s")),
+          fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down, "o/s")),
+          fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up, "o/s")),
+          fmt::arg("bandwidthTotalOctets", pow_format(bandwidth_up + bandwidth_down, "o/s")),
+          fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down, "B/s")),
+          fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up, "B/s")),
+          fmt::arg("bandwidthTotalBytes", pow_format(bandwidth_up + bandwidth_down, "B/s")));
       if (label_.get_tooltip_text() != tooltip_text) {
         label_.set_tooltip_markup(tooltip_text);
       }
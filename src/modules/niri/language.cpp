@@ -59,10 +59,10 @@ void Language::doUpdate() {
   spdlog::debug("niri language update with variant {}", layout.variant);
 
   if (!last_short_name_.empty()) {
-    label_.get_style_context()->remove_class(last_short_name_);
+    label_.remove_class(last_short_name_);
   }
   if (!layout.short_name.empty()) {
-    label_.get_style_context()->add_class(layout.short_name);
+    label_.add_class(layout.short_name);
     last_short_name_ = layout.short_name;
   } else {
     last_short_name_.clear();
@@ -162,9 +162,9 @@ auto PowerProfilesDaemon::update() -> void {
 
     // Set CSS class
     if (!currentStyle_.empty()) {
-      label_.get_style_context()->remove_class(currentStyle_);
+      label_.remove_class(currentStyle_);
     }
-    label_.get_style_context()->add_class(profile.name);
+    label_.add_class(profile.name);
     currentStyle_ = profile.name;
     event_box_.set_visible(true);
   } else {
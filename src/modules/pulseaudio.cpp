@@ -74,9 +74,9 @@ auto waybar::modules::Pulseaudio::update() -> void {
     std::string format_name = "format";
     if (backend->isBluetooth()) {
       format_name = format_name + "-bluetooth";
-      label_.get_style_context()->add_class("bluetooth");
+      label_.add_class("bluetooth");
     } else {
-      label_.get_style_context()->remove_class("bluetooth");
+      label_.remove_class("bluetooth");
     }
     if (backend->getSinkMuted()) {
       // Check muted bluetooth format exist, otherwise fallback to default muted format
@@ -84,11 +84,11 @@ auto waybar::modules::Pulseaudio::update() -> void {
         format_name = "format";
       }
       format_name = format_name + "-muted";
-      label_.get_style_context()->add_class("muted");
-      label_.get_style_context()->add_class("sink-muted");
+      label_.add_class("muted");
+      label_.add_class("sink-muted");
     } else {
-      label_.get_style_context()->remove_class("muted");
-      label_.get_style_context()->remove_class("sink-muted");
+      label_.remove_class("muted");
+      label_.remove_class("sink-muted");
     }
     auto state = getState(sink_volume, true);
     if (!state.empty() && config_[format_name + "-" + state].isString()) {
@@ -100,12 +100,12 @@ auto waybar::modules::Pulseaudio::update() -> void {
   // TODO: find a better way to split source/sink
   std::string format_source = "{volume}%";
   if (backend->getSourceMuted()) {
-    label_.get_style_context()->add_class("source-muted");
+    label_.add_class("source-muted");
     if (config_["format-source-muted"].isString()) {
       format_source = config_["format-source-muted"].asString();
     }
   } else {
-    label_.get_style_context()->remove_class("source-muted");
+    label_.remove_class("source-muted");
     if (config_["format-source"].isString()) {
       format_source = config_["format-source"].asString();
     }
@@ -146,10 +146,10 @@ void Layout::handle_name(const char *name) {
     label_.hide();  // hide empty labels or labels with empty format
   } else {
     if (!name_.empty()) {
-      label_.get_style_context()->remove_class(name_);
+      label_.remove_class(name_);
     }
 
-    label_.get_style_context()->add_class(name);
+    label_.add_class(name);
     label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(name).raw()));
     label_.show();
   }
@@ -164,7 +164,7 @@ void Layout::handle_clear() {
 
 void Layout::handle_focused_output(struct wl_output *output) {
   if (output_ == output) {  // if we focused the output this bar belongs to
-    label_.get_style_context()->add_class("focused");
+    label_.add_class("focused");
     ALabel::update();
   }
   focused_output_ = output;
@@ -172,7 +172,7 @@ void Layout::handle_focused_output(struct wl_output *output) {
 
 void Layout::handle_unfocused_output(struct wl_output *output) {
   if (output_ == output) {  // if we unfocused the output this bar belongs to
-    label_.get_style_context()->remove_class("focused");
+    label_.remove_class("focused");
     ALabel::update();
   }
 }
@@ -99,10 +99,10 @@ void Mode::handle_mode(const char *mode) {
     label_.hide();
   } else {
     if (!mode_.empty()) {
-      label_.get_style_context()->remove_class(mode_);
+      label_.remove_class(mode_);
     }
 
-    label_.get_style_context()->add_class(mode);
+    label_.add_class(mode);
     label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(mode).raw()));
     label_.show();
   }
@@ -118,7 +118,7 @@ void Window::handle_focused_view(const char *title) {
 
 void Window::handle_focused_output(struct wl_output *output) {
   if (output_ == output) {  // if we focused the output this bar belongs to
-    label_.get_style_context()->add_class("focused");
+    label_.add_class("focused");
     ALabel::update();
   }
   focused_output_ = output;
@@ -126,7 +126,7 @@ void Window::handle_focused_output(struct wl_output *output) {
 
 void Window::handle_unfocused_output(struct wl_output *output) {
   if (output_ == output) {  // if we unfocused the output this bar belongs to
-    label_.get_style_context()->remove_class("focused");
+    label_.remove_class("focused");
     ALabel::update();
   }
 }
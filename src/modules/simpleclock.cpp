@@ -4,14 +4,8 @@
 
 waybar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
     : ALabel(config, "clock", id, "{:%H:%M}", 60) {
-  thread_ = [this] {
-    dp.emit();
-    auto now = std::chrono::system_clock::now();
-    /* difference with projected wakeup time */
-    auto diff = now.time_since_epoch() % interval_;
-    /* sleep until the next projected time */
-    thread_.sleep_for(interval_ - diff);
-  };
+  /* ticks are aligned on multiples of the interval by the scheduler */
+  timer_ = util::Scheduler::inst().schedule(interval_, [this] { dp.emit(); });
 }
 
 auto waybar::modules::Clock::update() -> void {
@@ -42,9 +42,9 @@ auto Scratchpad::update() -> void {
     event_box_.hide();
   }
   if (count_) {
-    label_.get_style_context()->remove_class("empty");
+    label_.remove_class("empty");
   } else {
-    label_.get_style_context()->add_class("empty");
+    label_.add_class("empty");
   }
   ALabel::update();
 }
@@ -143,10 +143,10 @@ auto SystemdFailedUnits::update() -> void {
 
   // Set state class.
   if (!last_status.empty() && label_.get_style_context()->has_class(last_status)) {
-    label_.get_style_context()->remove_class(last_status);
+    label_.remove_class(last_status);
   }
   if (!label_.get_style_context()->has_class(overall_state)) {
-    label_.get_style_context()->add_class(overall_state);
+    label_.add_class(overall_state);
   }
 
   last_status = overall_state;
@@ -10,7 +10,8 @@
 waybar::modules::Temperature::Temperature(const std::string& id, const Json::Value& config)
     : ALabel(config, "temperature", id, "{temperatureC}°C", 10) {
 #if defined(__FreeBSD__)
-// FreeBSD uses sysctlbyname instead of read from a file
+  // FreeBSD uses sysctlbyname instead of read from a file
+  timer_ = util::Scheduler::inst().schedule(interval_, [this] { dp.emit(); });
 #else
   auto traverseAsArray = [](const Json::Value& value, auto&& check_set_path) {
     if (value.isString())
@@ -55,15 +56,27 @@ waybar::modules::Temperature::Temperature(const std::string& id, const Json::Val
     throw std::runtime_error("Can't read from " + file_path_);
   }
   temp.close();
-#endif
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  sampler_ = util::SystemSampler::inst().subscribe(
+      interval_, {util::SystemSampler::INPUTS, {file_path_}}, &dp);
+#endif
 }
 
 auto waybar::modules::Temperature::update() -> void {
+#if !defined(__FreeBSD__)
+  auto snapshot = sampler_.snapshot();
+  if (!snapshot) {
+    return;
+  }
+  auto input = snapshot->inputs.find(file_path_);
+  if (input != snapshot->inputs.end() && input->second.changed <= rendered_version_ &&
+      format_ == rendered_format_) {
+    // Neither the temperature nor the format (format-alt) changed since the last render
+    return;
+  }
+  rendered_version_ = snapshot->version;
+  rendered_format_ = format_;
+#endif
   auto temperature = getTemperature();
   uint16_t temperature_c = std::round(temperature);
   uint16_t temperature_f = std::round(temperature * 1.8 + 32);
@@ -77,12 +90,12 @@ auto waybar::modules::Temperature::update() -> void {
     ctx->add_class("critical");
     ctx->remove_class("warning");
   } else {
-    label_.get_style_context()->remove_class("critical");
+    label_.remove_class("critical");
     if (warning) {
       format = config_["format-warning"].isString() ? config_["format-warning"].asString() : format;
-      label_.get_style_context()->add_class("warning");
+      label_.add_class("warning");
     } else {
-      label_.get_style_context()->remove_class("warning");
+      label_.remove_class("warning");
     }
   }
 
@@ -131,19 +144,12 @@ float waybar::modules::Temperature::getTemperature() {
       "sysctl hw.acpi.thermal.tz{}.temperature and dev.cpu.{}.temperature failed", zone, zone));
 
 #else  // Linux
-  std::ifstream temp(file_path_);
-  if (!temp.is_open()) {
-    throw std::runtime_error("Can't open " + file_path_);
-  }
-  std::string line;
-  if (temp.good()) {
-    getline(temp, line);
-  } else {
-    temp.close();
+  auto snapshot = sampler_.snapshot();
+  auto input = snapshot->inputs.find(file_path_);
+  if (input == snapshot->inputs.end()) {
     throw std::runtime_error("Can't read from " + file_path_);
   }
-  temp.close();
-  auto temperature_c = std::strtol(line.c_str(), nullptr, 10) / 1000.0;
+  auto temperature_c = input->second.value / 1000.0;
   return temperature_c;
 #endif
 }
@@ -81,12 +81,8 @@ std::string User::get_user_login() const { return Glib::get_user_name(); }
 std::string User::get_user_home_dir() const { return Glib::get_home_dir(); }
 
 void User::init_update_worker() {
-  this->thread_ = [this] {
-    ALabel::dp.emit();
-    auto now = std::chrono::system_clock::now();
-    auto diff = now.time_since_epoch() % ALabel::interval_;
-    this->thread_.sleep_for(ALabel::interval_ - diff);
-  };
+  this->timer_ =
+      util::Scheduler::inst().schedule(ALabel::interval_, [this] { ALabel::dp.emit(); });
 }
 
 void User::init_avatar(const Json::Value& config) {
@@ -422,18 +422,18 @@ auto waybar::modules::Wireplumber::update() -> void {
   // Handle sink mute state
   if (muted_) {
     format = config_["format-muted"].isString() ? config_["format-muted"].asString() : format;
-    label_.get_style_context()->add_class("muted");
-    label_.get_style_context()->add_class("sink-muted");
+    label_.add_class("muted");
+    label_.add_class("sink-muted");
   } else {
-    label_.get_style_context()->remove_class("muted");
-    label_.get_style_context()->remove_class("sink-muted");
+    label_.remove_class("muted");
+    label_.remove_class("sink-muted");
   }
 
   // Handle source mute state
   if (source_muted_) {
-    label_.get_style_context()->add_class("source-muted");
+    label_.add_class("source-muted");
   } else {
-    label_.get_style_context()->remove_class("source-muted");
+    label_.remove_class("source-muted");
   }
 
   int vol = round(volume_ * 100.0);
@@ -0,0 +1,234 @@
+#include "util/control_socket.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace waybar::util {
+
+namespace {
+// A client sending a longer line is disconnected
+constexpr size_t MAX_REQUEST = 64 * 1024;
+// A client leaving more replies unread is disconnected
+constexpr size_t MAX_REPLIES = 16 * 1024 * 1024;
+
+sockaddr_un address(const std::string& path) {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Control socket path too long: " + path);
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return addr;
+}
+
+// Whether a process accepts connections on `path`
+bool listening(const sockaddr_un& addr) {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    return false;
+  }
+  bool connected = connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+  close(fd);
+  return connected;
+}
+}  // namespace
+
+ControlSocket::ControlSocket(std::string path, Handler handler, std::function<void()> flush)
+    : path_(std::move(path)), handler_(std::move(handler)), flush_(std::move(flush)) {
+  auto addr = address(path_);
+  if (listening(addr)) {
+    throw std::runtime_error("Control socket " + path_ + " is used by another process");
+  }
+  unlink(path_.c_str());
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ == -1 || bind(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      chmod(path_.c_str(), 0600) != 0 || listen(fd_, 16) != 0) {
+    std::string error = strerror(errno);
+    if (fd_ != -1) {
+      close(fd_);
+    }
+    throw std::runtime_error("Unable to listen on " + path_ + ": " + error);
+  }
+  accept_ = Glib::signal_io().connect(sigc::mem_fun(*this, &ControlSocket::onAccept), fd_,
+                                      Glib::IO_IN);
+}
+
+ControlSocket::~ControlSocket() {
+  accept_.disconnect();
+  while (!connections_.empty()) {
+    disconnect(connections_.begin()->first);
+  }
+  close(fd_);
+  unlink(path_.c_str());
+}
+
+std::string ControlSocket::defaultPath() {
+  const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+  if (runtime_dir == nullptr || *runtime_dir == '\0') {
+    return {};
+  }
+  const char* display = getenv("WAYLAND_DISPLAY");
+  return std::string(runtime_dir) + "/waybar-" + (display != nullptr ? display : "wayland-0") +
+         ".sock";
+}
+
+std::optional<ControlSocket::Request> ControlSocket::parse(std::string_view line) {
+  if (line.ends_with('\r')) {
+    line.remove_suffix(1);
+  }
+  // Next word of `line`, which is left with what follows its separating space
+  auto word = [&line] {
+    auto start = line.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+      line = {};
+      return std::string();
+    }
+    auto end = std::min(line.find(' ', start), line.size());
+    std::string word(line.substr(start, end - start));
+    line.remove_prefix(std::min(end + 1, line.size()));
+    return word;
+  };
+  Request request;
+  request.command = word();
+  if (request.command.empty()) {
+    return std::nullopt;
+  }
+  request.module = word();
+  if (auto at = request.module.rfind('@'); at != std::string::npos) {
+    request.output = request.module.substr(at + 1);
+    request.module.erase(at);
+  }
+  request.argument = line;
+  return request;
+}
+
+bool ControlSocket::onAccept(Glib::IOCondition /*condition*/) {
+  int fd;
+  while ((fd = accept4(fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+    auto& connection = connections_[fd];
+    connection.fd = fd;
+    connection.io = Glib::signal_io().connect(
+        sigc::bind<0>(sigc::mem_fun(*this, &ControlSocket::onReadable), fd), fd,
+        Glib::IO_IN | Glib::IO_HUP | Glib::IO_ERR);
+  }
+  if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    spdlog::error("Control socket stopped accepting clients: {}", strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool ControlSocket::onReadable(int fd, Glib::IOCondition /*condition*/) {
+  auto& connection = connections_.at(fd);
+  auto& replies = connection.replies;
+  bool open = true;
+  std::array<char, 4096> chunk;
+  while (true) {
+    auto n = read(fd, chunk.data(), chunk.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+      break;
+    }
+    connection.buffer.append(chunk.data(), n);
+    size_t start = 0;
+    size_t end;
+    while ((end = connection.buffer.find('\n', start)) != std::string::npos) {
+      auto request = parse(std::string_view(connection.buffer).substr(start, end - start));
+      start = end + 1;
+      if (request) {
+        try {
+          replies += handler_(*request);
+        } catch (const std::exception& e) {
+          spdlog::error("Control socket request failed: {}", e.what());
+          replies += "error ";
+          replies += e.what();
+        }
+        replies += '\n';
+      }
+    }
+    connection.buffer.erase(0, start);
+    if (connection.buffer.size() > MAX_REQUEST) {
+      replies += "error request too long\n";
+      open = false;
+      break;
+    }
+  }
+  flush_();
+
+  if (!sendReplies(connection) || (!open && replies.empty())) {
+    disconnect(fd);
+    return false;
+  }
+  if (!open) {
+    // Nothing more to read, the rest of the replies still goes out
+    connection.closing = true;
+    connection.io.disconnect();
+    return false;
+  }
+  return true;
+}
+
+bool ControlSocket::onWritable(int fd, Glib::IOCondition /*condition*/) {
+  auto& connection = connections_.at(fd);
+  if (!sendReplies(connection) || (connection.closing && connection.replies.empty())) {
+    disconnect(fd);
+    return false;
+  }
+  return !connection.replies.empty();
+}
+
+bool ControlSocket::sendReplies(Connection& connection) {
+  auto& replies = connection.replies;
+  size_t sent = 0;
+  while (sent < replies.size()) {
+    auto n = send(connection.fd, replies.data() + sent, replies.size() - sent,
+                  MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (n < 0) {
+      spdlog::debug("Control socket client is gone: {}", strerror(errno));
+      return false;
+    }
+    sent += n;
+  }
+  replies.erase(0, sent);
+  if (replies.size() > MAX_REPLIES) {
+    spdlog::debug("Control socket client does not read its replies");
+    return false;
+  }
+  if (replies.empty()) {
+    connection.write_io.disconnect();
+  } else if (!connection.write_io.connected()) {
+    connection.write_io = Glib::signal_io().connect(
+        sigc::bind<0>(sigc::mem_fun(*this, &ControlSocket::onWritable), connection.fd),
+        connection.fd, Glib::IO_OUT | Glib::IO_HUP | Glib::IO_ERR);
+  }
+  return true;
+}
+
+void ControlSocket::disconnect(int fd) {
+  auto it = connections_.find(fd);
+  if (it == connections_.end()) {
+    return;
+  }
+  it->second.io.disconnect();
+  it->second.write_io.disconnect();
+  close(fd);
+  connections_.erase(it);
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,72 @@
+#include "util/exec_cache.hpp"
+
+#include "util/scope_guard.hpp"
+#include "util/telemetry.hpp"
+
+namespace waybar::util {
+
+ExecCache& ExecCache::inst() {
+  static auto* inst = new ExecCache();
+  return *inst;
+}
+
+command::res ExecCache::exec(const std::string& cmd, const std::string& output_name,
+                             std::chrono::milliseconds ttl) {
+  const auto& stats = Telemetry::current();
+  std::unique_lock lock(mutex_);
+  // References to map entries stay valid while other entries are added
+  auto& entry = entries_[{cmd, output_name}];
+  while (entry.running) {
+    auto runs = entry.runs;
+    done_.wait(lock, [&entry] { return !entry.running; });
+    // Otherwise the run was cancelled or threw, start another one
+    if (entry.runs != runs) {
+      if (stats) {
+        stats->exec_joined++;
+      }
+      return entry.result;
+    }
+  }
+  if (entry.done_at && std::chrono::steady_clock::now() - *entry.done_at < ttl) {
+    if (stats) {
+      stats->exec_hits++;
+    }
+    return entry.result;
+  }
+  if (stats) {
+    stats->exec_misses++;
+  }
+
+  entry.running = true;
+  lock.unlock();
+  command::res result;
+  {
+    // Also runs when the worker is cancelled in command::exec, or waiters would never wake up
+    ScopeGuard done([this, &entry] {
+      std::lock_guard done_lock(mutex_);
+      entry.running = false;
+      done_.notify_all();
+    });
+    result = command::exec(cmd, output_name);
+    lock.lock();
+    entry.result = result;
+    entry.done_at = std::chrono::steady_clock::now();
+    entry.runs++;
+    lock.unlock();
+  }
+  return result;
+}
+
+std::optional<std::chrono::milliseconds> ExecCache::ttl(const Json::Value& config) {
+  const auto& cache = config["exec-cache"];
+  if (cache.isNumeric()) {
+    return std::chrono::milliseconds(
+        std::max(0L, static_cast<long>(cache.asDouble() * 1000)));
+  }
+  if (cache.isBool() && cache.asBool()) {
+    return std::chrono::milliseconds(0);
+  }
+  return std::nullopt;
+}
+
+}  // namespace waybar::util
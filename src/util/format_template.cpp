@@ -0,0 +1,76 @@
+#include "util/format_template.hpp"
+
+#include <algorithm>
+
+namespace waybar::util {
+
+FormatTemplate::FormatTemplate(std::string_view format, const Binder& bind) {
+  size_t next_auto_index = 0;
+  size_t literal_start = 0;
+  auto addLiteral = [this, &literal_start]() {
+    if (literal_start < literals_.size()) {
+      pieces_.push_back({-1, literal_start, literals_.size() - literal_start});
+    }
+    literal_start = literals_.size();
+  };
+
+  for (size_t i = 0; i < format.size(); i++) {
+    char c = format[i];
+    if (c == '}') {
+      if (i + 1 < format.size() && format[i + 1] == '}') {
+        literals_ += '}';
+        i++;
+        continue;
+      }
+      throw fmt::format_error("unmatched '}' in format string");
+    }
+    if (c != '{') {
+      literals_ += c;
+      continue;
+    }
+    if (i + 1 < format.size() && format[i + 1] == '{') {
+      literals_ += '{';
+      i++;
+      continue;
+    }
+    auto close = format.find_first_of("{}", i + 1);
+    if (close == std::string_view::npos) {
+      throw fmt::format_error("invalid format string");
+    }
+    if (format[close] == '{') {
+      throw fmt::format_error("nested replacement fields are not supported");
+    }
+    auto content = format.substr(i + 1, close - i - 1);
+    auto colon = content.find(':');
+    Field field;
+    field.name = std::string(content.substr(0, colon));
+    if (field.name.empty()) {
+      field.name = std::to_string(next_auto_index++);
+    }
+    if (colon != std::string_view::npos) {
+      field.spec = fmt::format("{{:{}}}", content.substr(colon + 1));
+    }
+    if (bind) {
+      field.slot = bind(field.name, field.index);
+    }
+    addLiteral();
+    pieces_.push_back({static_cast<int>(fields_.size()), 0, 0});
+    fields_.push_back(std::move(field));
+    i = close;
+  }
+  addLiteral();
+}
+
+bool FormatTemplate::uses(std::string_view name) const {
+  return std::ranges::any_of(fields_, [name](const auto& field) { return field.name == name; });
+}
+
+bool FormatTemplate::usesSlot(int slot) const {
+  return std::ranges::any_of(fields_, [slot](const auto& field) { return field.slot == slot; });
+}
+
+void FormatTemplate::unknownField(const Field& field) {
+  throw fmt::format_error("argument not found: " + field.name);
+}
+
+}  // namespace waybar::util
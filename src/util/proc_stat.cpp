@@ -0,0 +1,163 @@
+#include "util/proc_stat.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace waybar::util {
+
+namespace {
+constexpr size_t INITIAL_BUFFER_SIZE = 16384;
+
+const char* skipSpaces(const char* p, const char* end) {
+  while (p < end && *p == ' ') {
+    ++p;
+  }
+  return p;
+}
+}  // namespace
+
+ProcStat::ProcStat(std::string path, std::string present_path)
+    : path_(std::move(path)), present_path_(std::move(present_path)) {
+  fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  // Get the "existing CPU count" from /sys/devices/system/cpu/present
+  // Probably this is what the user wants the offline CPUs accounted from
+  // For further details see:
+  // https://www.kernel.org/doc/html/latest/core-api/cpu_hotplug.html
+  present_fd_ = open(present_path_.c_str(), O_RDONLY | O_CLOEXEC);
+  buffer_.resize(INITIAL_BUFFER_SIZE);
+  present_buffer_.resize(256);
+}
+
+ProcStat::~ProcStat() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+  if (present_fd_ != -1) {
+    close(present_fd_);
+  }
+}
+
+std::string_view ProcStat::readAll(int fd, std::vector<char>& buffer) {
+  size_t len = 0;
+  while (true) {
+    if (len == buffer.size()) {
+      // Only grows until the buffer fits the whole file once
+      buffer.resize(buffer.size() * 2);
+    }
+    auto n = pread(fd, buffer.data() + len, buffer.size() - len, static_cast<off_t>(len));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("pread failed: ") + strerror(errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    len += n;
+  }
+  return {buffer.data(), len};
+}
+
+size_t ProcStat::readPresentLast() {
+  if (present_fd_ == -1) {
+    return 0;
+  }
+  std::string_view present;
+  try {
+    present = readAll(present_fd_, present_buffer_);
+  } catch (const std::runtime_error&) {
+    return 0;
+  }
+  // This is a comma-separated list of ranges, eg. 0,2-4,7
+  auto last_separator = present.find_last_of("-,");
+  auto last = last_separator == std::string_view::npos ? present : present.substr(last_separator + 1);
+  size_t value = 0;
+  std::from_chars(last.data(), last.data() + last.size(), value);
+  return value;
+}
+
+void ProcStat::read(CpuTimes& times) {
+  if (fd_ == -1) {
+    throw std::runtime_error("Can't open " + path_);
+  }
+  auto present_last = readPresentLast();
+  parse(readAll(fd_, buffer_), present_last, times);
+}
+
+void ProcStat::parse(std::string_view data, size_t present_last, CpuTimes& times) {
+  // clear() keeps the capacity, so that only the first parse allocates
+  times.idle.clear();
+  times.total.clear();
+
+  const char* p = data.data();
+  const char* const end = p + data.size();
+  bool aggregate = true;  // First line is total, second line is cpu 0
+  size_t next_cpu = 0;
+  while (p < end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+      eol = end;
+    }
+    if (eol - p < 3 || memcmp(p, "cpu", 3) != 0) {
+      break;
+    }
+    p += 3;
+    if (!aggregate) {
+      size_t cpu = 0;
+      p = std::from_chars(p, eol, cpu).ptr;
+      while (cpu > next_cpu) {
+        // Fill in 0 for offline CPUs missing inside the lines of /proc/stat
+        times.idle.push_back(0);
+        times.total.push_back(0);
+        next_cpu++;
+      }
+    }
+
+    uint64_t idle = 0;
+    uint64_t total = 0;
+    size_t fields = 0;
+    while (true) {
+      p = skipSpaces(p, eol);
+      uint64_t value = 0;
+      auto [ptr, ec] = std::from_chars(p, eol, value);
+      if (ec != std::errc()) {
+        break;
+      }
+      p = ptr;
+      // idle + iowait
+      if (fields == 3 || fields == 4) {
+        idle += value;
+      }
+      total += value;
+      fields++;
+    }
+    if (fields < 5) {
+      idle = 0;
+      total = 0;
+    }
+    times.idle.push_back(idle);
+    times.total.push_back(total);
+
+    if (aggregate) {
+      aggregate = false;
+    } else {
+      next_cpu++;
+    }
+    p = eol + 1;
+  }
+
+  while (!aggregate && present_last >= next_cpu) {
+    // Fill in 0 for offline CPUs missing after the lines of /proc/stat
+    times.idle.push_back(0);
+    times.total.push_back(0);
+    next_cpu++;
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,390 @@
+#include "util/process_reactor.hpp"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "util/spawn.hpp"
+
+namespace waybar::util {
+
+namespace {
+// epoll data of the event fd, the others use (id << 2) | their kind with ids from 1
+constexpr uint64_t WAKE_UP = 0;
+constexpr uint64_t KIND_OUT = 0;
+constexpr uint64_t KIND_PIDFD = 1;
+constexpr uint64_t KIND_FILE = 2;
+// How often exits are polled for without a pidfd
+constexpr int REAP_POLL_MS = 100;
+
+void add(int epoll_fd, int fd, uint64_t data) {
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = data;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    spdlog::error("epoll_ctl failed: {}", strerror(errno));
+  }
+}
+
+// Content of the file at `path` without its last newline, empty if it can't be read
+std::string readFile(const std::string& path) {
+  std::ifstream file(path);
+  std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (content.ends_with('\n')) {
+    content.pop_back();
+  }
+  return content;
+}
+
+// Handlers run on the reactor thread: one that throws must not take the others, or Waybar, down
+template <typename Handler, typename... Args>
+void call(const Handler& handler, Args&&... args) {
+  try {
+    handler(std::forward<Args>(args)...);
+  } catch (const std::exception& e) {
+    spdlog::error("Process reactor handler failed: {}", e.what());
+  }
+}
+
+void closeFd(int& fd) {
+  if (fd != -1) {
+    // Closing also removes it from the epoll set
+    close(fd);
+    fd = -1;
+  }
+}
+}  // namespace
+
+ProcessReactor::Watch& ProcessReactor::Watch::operator=(Watch&& other) noexcept {
+  if (this != &other) {
+    reset();
+    id_ = std::exchange(other.id_, 0);
+  }
+  return *this;
+}
+
+void ProcessReactor::Watch::reset() {
+  if (id_ != 0) {
+    ProcessReactor::inst().remove(std::exchange(id_, 0));
+  }
+}
+
+ProcessReactor& ProcessReactor::inst() {
+  static auto* inst = new ProcessReactor();
+  return *inst;
+}
+
+ProcessReactor::ProcessReactor()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), event_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (epoll_fd_ == -1 || event_fd_ == -1) {
+    throw std::runtime_error(std::string("Unable to create process reactor: ") + strerror(errno));
+  }
+  add(epoll_fd_, event_fd_, WAKE_UP);
+  thread_ = std::thread([this] { run(); });
+  thread_.detach();
+}
+
+ProcessReactor::Watch ProcessReactor::watch(Command command, Handler handler) {
+  std::lock_guard lock(mutex_);
+  auto id = next_id_++;
+  auto& child = children_[id];
+  child.command = std::move(command);
+  child.handler = std::move(handler);
+  child.stats = Telemetry::current();
+  if (!start(id, child)) {
+    auto cmd = child.command.cmd;
+    children_.erase(id);
+    throw std::runtime_error("Unable to open " + cmd);
+  }
+  return Watch(id);
+}
+
+ProcessReactor::Watch ProcessReactor::watchFile(const std::string& path, FileHandler handler) {
+  auto absolute = std::filesystem::absolute(path).lexically_normal();
+  File file;
+  file.path = absolute.string();
+  file.name = absolute.filename().string();
+  file.handler = std::move(handler);
+  struct stat st;
+  file.fifo = stat(file.path.c_str(), &st) == 0 && S_ISFIFO(st.st_mode);
+  if (file.fifo) {
+    // Also open it for writing, it never reaches EOF then when its last writer closes it
+    file.fd = open(file.path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  } else {
+    file.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    // Watch the directory to also see the file replaced by a rename, created or removed. Not
+    // IN_MODIFY: a file rewritten in place is truncated first, it would be read empty or partial.
+    constexpr uint32_t MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+    if (file.fd != -1 && inotify_add_watch(file.fd, absolute.parent_path().c_str(), MASK) == -1) {
+      int error = errno;
+      closeFd(file.fd);
+      errno = error;
+    }
+  }
+  if (file.fd == -1) {
+    throw std::runtime_error("Unable to watch " + path + ": " + strerror(errno));
+  }
+
+  std::lock_guard lock(mutex_);
+  auto id = next_id_++;
+  if (!file.fifo) {
+    file.handler(readFile(file.path));
+  }
+  add(epoll_fd_, file.fd, (id << 2) | KIND_FILE);
+  files_.emplace(id, std::move(file));
+  return Watch(id);
+}
+
+size_t ProcessReactor::size() const {
+  std::lock_guard lock(mutex_);
+  return children_.size() + files_.size();
+}
+
+bool ProcessReactor::start(uint64_t id, Child& child) {
+  int fd[2];
+  if (pipe2(fd, O_CLOEXEC) != 0) {
+    spdlog::error("Unable to pipe fd");
+    return false;
+  }
+  SpawnOptions options;
+  options.stdout_fd = fd[1];
+  options.deathsig = SIGTERM;
+  options.output_name = child.command.output_name;
+  pid_t pid = spawn(child.command.cmd, options);
+  close(fd[1]);
+  if (pid < 0) {
+    spdlog::error("Unable to exec cmd {}, error {}", child.command.cmd, strerror(errno));
+    close(fd[0]);
+    return false;
+  }
+  if (child.stats) {
+    child.stats->forks++;
+  }
+  // Only our end is non-blocking, the child writes as usual
+  fcntl(fd[0], F_SETFL, fcntl(fd[0], F_GETFL) | O_NONBLOCK);
+  child.pid = pid;
+  child.out = fd[0];
+  child.buffer.clear();
+  child.restart_at.reset();
+  add(epoll_fd_, child.out, (id << 2) | KIND_OUT);
+#ifdef SYS_pidfd_open
+  // Fails before Linux 5.3, the exit is then polled for
+  child.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+  if (child.pidfd != -1) {
+    add(epoll_fd_, child.pidfd, (id << 2) | KIND_PIDFD);
+  }
+#endif
+  return true;
+}
+
+void ProcessReactor::remove(uint64_t id) {
+  std::lock_guard lock(mutex_);
+  if (auto file = files_.find(id); file != files_.end()) {
+    closeFd(file->second.fd);
+    files_.erase(file);
+    return;
+  }
+  auto it = children_.find(id);
+  if (it == children_.end()) {
+    return;
+  }
+  auto& child = it->second;
+  closeFd(child.out);
+  closeFd(child.pidfd);
+  if (child.pid > 0) {
+    killpg(child.pid, SIGTERM);
+    orphans_.push_back(child.pid);
+    wakeUp();
+  }
+  children_.erase(it);
+}
+
+bool ProcessReactor::drain(int fd, std::string& buffer,
+                           const std::function<void(std::string)>& line) {
+  std::array<char, 4096> chunk;
+  while (true) {
+    auto n = read(fd, chunk.data(), chunk.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      // Any error but EAGAIN leaves nothing more to read
+      return n < 0 && errno == EAGAIN;
+    }
+    buffer.append(chunk.data(), n);
+    size_t start = 0;
+    size_t end;
+    while ((end = buffer.find('\n', start)) != std::string::npos) {
+      call(line, buffer.substr(start, end - start));
+      start = end + 1;
+    }
+    buffer.erase(0, start);
+  }
+}
+
+bool ProcessReactor::changed(File& file) {
+  // Large enough for a few events with a name of NAME_MAX
+  alignas(inotify_event) std::array<char, 4 * (sizeof(inotify_event) + NAME_MAX + 1)> events;
+  bool changed = false;
+  while (true) {
+    auto n = read(file.fd, events.data(), events.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return changed;
+    }
+    for (ssize_t offset = 0; offset < n;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+      if ((event->mask & IN_IGNORED) != 0) {
+        spdlog::warn("The directory of {} was removed, it is no longer watched", file.path);
+        closeFd(file.fd);
+        return true;
+      }
+      if (event->len > 0 && file.name == event->name) {
+        changed = true;
+      }
+      offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+    }
+  }
+}
+
+void ProcessReactor::reap(Child& child, bool block) {
+  int status = 0;
+  if (waitpid(child.pid, &status, block ? 0 : WNOHANG) == 0) {
+    return;
+  }
+  if (child.out != -1) {
+    drain(child.out, child.buffer, child.handler.line);
+    closeFd(child.out);
+  }
+  closeFd(child.pidfd);
+  child.pid = -1;
+  // The last line may miss its newline
+  if (!child.buffer.empty()) {
+    call(child.handler.line, std::move(child.buffer));
+    child.buffer.clear();
+  }
+  int exit_code = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+  call(child.handler.exit, exit_code);
+  if (child.command.restart_interval) {
+    child.restart_at = std::chrono::steady_clock::now() + *child.command.restart_interval;
+  } else {
+    child.done = true;
+  }
+}
+
+int ProcessReactor::timeout() const {
+  auto now = std::chrono::steady_clock::now();
+  int timeout = orphans_.empty() ? -1 : REAP_POLL_MS;
+  auto limit = [&timeout](int ms) { timeout = timeout == -1 ? ms : std::min(timeout, ms); };
+  for (const auto& [id, child] : children_) {
+    if (child.restart_at) {
+      auto left = std::chrono::ceil<std::chrono::milliseconds>(*child.restart_at - now);
+      limit(static_cast<int>(std::max<int64_t>(0, left.count())));
+    } else if (child.pid > 0 && child.pidfd == -1 && child.out == -1) {
+      limit(REAP_POLL_MS);
+    }
+  }
+  return timeout;
+}
+
+void ProcessReactor::wakeUp() const {
+  uint64_t one = 1;
+  if (write(event_fd_, &one, sizeof(one)) < 0) {
+    spdlog::debug("Unable to wake up the process reactor: {}", strerror(errno));
+  }
+}
+
+void ProcessReactor::run() {
+  std::array<epoll_event, 32> events;
+  while (true) {
+    int timeout;
+    {
+      std::lock_guard lock(mutex_);
+      timeout = this->timeout();
+    }
+    int n = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      spdlog::error("Process reactor stopped, epoll_wait failed: {}", strerror(errno));
+      return;
+    }
+
+    std::lock_guard lock(mutex_);
+    for (int i = 0; i < n; i++) {
+      auto data = events[i].data.u64;
+      if (data == WAKE_UP) {
+        uint64_t count;
+        while (read(event_fd_, &count, sizeof(count)) > 0) {
+        }
+        continue;
+      }
+      if ((data & 3) == KIND_FILE) {
+        // Several writes reported at once cost one read
+        auto file = files_.find(data >> 2);
+        if (file == files_.end()) {
+          continue;
+        }
+        auto& watched = file->second;
+        if (watched.fifo) {
+          drain(watched.fd, watched.buffer, watched.handler);
+        } else if (changed(watched)) {
+          call(watched.handler, readFile(watched.path));
+        }
+        continue;
+      }
+      // A descriptor of a child removed earlier in this batch
+      auto it = children_.find(data >> 2);
+      if (it == children_.end()) {
+        continue;
+      }
+      auto& child = it->second;
+      Telemetry::Scope scope(child.stats);
+      if ((data & 3) == KIND_PIDFD) {
+        // Readable once the child exited
+        if (child.pidfd != -1) {
+          reap(child, true);
+        }
+      } else if (child.out != -1 && !drain(child.out, child.buffer, child.handler.line)) {
+        closeFd(child.out);
+        if (child.pidfd == -1) {
+          reap(child, false);
+        }
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto& [id, child] : children_) {
+      Telemetry::Scope scope(child.stats);
+      if (child.restart_at && *child.restart_at <= now) {
+        if (!start(id, child)) {
+          child.restart_at.reset();
+          child.done = true;
+          call(child.handler.exit, -1);
+        }
+      } else if (child.pid > 0 && child.pidfd == -1 && child.out == -1) {
+        reap(child, false);
+      }
+    }
+    std::erase_if(children_, [](const auto& entry) { return entry.second.done; });
+    std::erase_if(orphans_, [](pid_t pid) { return waitpid(pid, nullptr, WNOHANG) != 0; });
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,71 @@
+#include "util/provider.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace waybar::util {
+
+namespace {
+std::unordered_map<std::string, std::weak_ptr<Provider>>& registry() {
+  static std::unordered_map<std::string, std::weak_ptr<Provider>> providers;
+  return providers;
+}
+}  // namespace
+
+void Provider::attach(Dispatcher& dp) {
+  {
+    std::lock_guard lock(dispatchers_mutex_);
+    dispatchers_.push_back(&dp);
+  }
+  // Let a late subscriber render the current sample right away
+  if (samples_ > 0) {
+    dp.emit();
+  }
+}
+
+void Provider::detach(Dispatcher& dp) {
+  std::lock_guard lock(dispatchers_mutex_);
+  std::erase(dispatchers_, &dp);
+}
+
+size_t Provider::subscribers() const {
+  std::lock_guard lock(dispatchers_mutex_);
+  return dispatchers_.size();
+}
+
+void Provider::notify() {
+  std::lock_guard lock(dispatchers_mutex_);
+  for (auto* dp : dispatchers_) {
+    dp->emit();
+  }
+}
+
+std::string Provider::makeKey(const std::string& type, const Json::Value& config) {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return type + '\n' + Json::writeString(builder, config);
+}
+
+std::mutex& Provider::registryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::shared_ptr<Provider> Provider::lookup(const std::string& key) {
+  auto it = registry().find(key);
+  if (it == registry().end()) {
+    return nullptr;
+  }
+  return it->second.lock();
+}
+
+void Provider::store(const std::string& key, const std::shared_ptr<Provider>& provider) {
+  auto& providers = registry();
+  std::erase_if(providers, [](const auto& entry) { return entry.second.expired(); });
+  providers[key] = provider;
+  spdlog::debug("Provider registry: {} live providers", providers.size());
+}
+
+}  // namespace waybar::util
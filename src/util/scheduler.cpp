@@ -0,0 +1,280 @@
+#include "util/scheduler.hpp"
+
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+namespace waybar::util {
+
+Scheduler::Subscription::Subscription(Subscription&& other) noexcept
+    : scheduler_(other.scheduler_), id_(other.id_) {
+  other.scheduler_ = nullptr;
+}
+
+Scheduler::Subscription& Scheduler::Subscription::operator=(Subscription&& other) noexcept {
+  if (this != &other) {
+    reset();
+    scheduler_ = other.scheduler_;
+    id_ = other.id_;
+    other.scheduler_ = nullptr;
+  }
+  return *this;
+}
+
+void Scheduler::Subscription::reset() {
+  if (scheduler_ != nullptr) {
+    scheduler_->cancel(id_);
+    scheduler_ = nullptr;
+  }
+}
+
+void Scheduler::Subscription::trigger() const {
+  if (scheduler_ != nullptr) {
+    scheduler_->trigger(id_);
+  }
+}
+
+Scheduler& Scheduler::inst() {
+  // Intentionally leaked: modules may still hold subscriptions during static destruction.
+  static auto* scheduler = new Scheduler();
+  return *scheduler;
+}
+
+Scheduler::Scheduler() {
+  timer_fd_ = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+  if (timer_fd_ == -1) {
+    throw std::runtime_error(std::string("Scheduler: timerfd_create failed: ") + strerror(errno));
+  }
+  event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd_ == -1) {
+    ::close(timer_fd_);
+    throw std::runtime_error(std::string("Scheduler: eventfd failed: ") + strerror(errno));
+  }
+  thread_ = std::thread(&Scheduler::run, this);
+}
+
+Scheduler::~Scheduler() {
+  running_ = false;
+  wake();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  ::close(timer_fd_);
+  ::close(event_fd_);
+}
+
+Scheduler::Subscription Scheduler::schedule(std::chrono::milliseconds interval, Callback cb,
+                                            bool immediate) {
+  uint64_t id;
+  {
+    std::lock_guard lock(mutex_);
+    id = next_id_++;
+    auto deadline = clock::now();
+    if (!immediate) {
+      deadline = interval == std::chrono::milliseconds::max() ? clock::time_point::max()
+                                                               : nextDeadline(deadline, interval);
+    }
+    tasks_.emplace(id, Task{interval, deadline, std::make_shared<Callback>(std::move(cb))});
+    if (deadline != clock::time_point::max()) {
+      queue_.emplace(deadline, id);
+    }
+  }
+  wake();
+  return {this, id};
+}
+
+void Scheduler::setSlack(std::chrono::milliseconds slack) {
+  slack_ = std::max(slack, std::chrono::milliseconds(0));
+  wake();
+}
+
+Scheduler::Stats Scheduler::stats() const {
+  std::lock_guard lock(mutex_);
+  auto stats = stats_;
+  stats.subscriptions = tasks_.size();
+  return stats;
+}
+
+void Scheduler::cancel(uint64_t id) {
+  {
+    std::lock_guard lock(mutex_);
+    tasks_.erase(id);
+  }
+  // Stale queue entries are dropped lazily. Wait for a running callback to return, unless we are
+  // being cancelled from inside one.
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    std::lock_guard run_lock(run_mutex_);
+  }
+}
+
+void Scheduler::trigger(uint64_t id) {
+  {
+    std::lock_guard lock(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) {
+      return;
+    }
+    it->second.deadline = clock::now();
+    queue_.emplace(it->second.deadline, id);
+  }
+  wake();
+}
+
+void Scheduler::wake() {
+  uint64_t one = 1;
+  if (::write(event_fd_, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+    spdlog::warn("Scheduler: unable to wake up timer thread: {}", strerror(errno));
+  }
+}
+
+Scheduler::clock::time_point Scheduler::nextDeadline(clock::time_point now,
+                                                     std::chrono::milliseconds interval) {
+  auto step = std::chrono::duration_cast<clock::duration>(interval);
+  // Align on the epoch so that every subscriber with the same interval shares a deadline
+  return now - now.time_since_epoch() % step + step;
+}
+
+void Scheduler::realign(clock::time_point now) {
+  for (auto& [id, task] : tasks_) {
+    // A "once" task that fired already, or waits for trigger()
+    if (task.deadline == clock::time_point::max()) {
+      continue;
+    }
+    task.deadline = now;
+    queue_.emplace(now, id);
+  }
+}
+
+void Scheduler::armTimer() {
+  struct itimerspec spec = {};
+  {
+    std::lock_guard lock(mutex_);
+    // Drop entries for cancelled or rescheduled tasks
+    while (!queue_.empty()) {
+      auto [deadline, id] = queue_.top();
+      auto it = tasks_.find(id);
+      if (it != tasks_.end() && it->second.deadline == deadline) {
+        // Coalesce by waiting for the subscriptions due within the slack, as firing them early
+        // would make clocks render the interval that is about to end
+        auto fire_at = deadline;
+        if (auto slack = slack_.load(); slack.count() > 0) {
+          for (const auto& [other_id, other] : tasks_) {
+            if (other.deadline > fire_at && other.deadline <= deadline + slack) {
+              fire_at = other.deadline;
+            }
+          }
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(fire_at.time_since_epoch());
+        spec.it_value.tv_sec = ns.count() / 1'000'000'000;
+        spec.it_value.tv_nsec = ns.count() % 1'000'000'000;
+        // A zeroed it_value would disarm the timer
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+          spec.it_value.tv_nsec = 1;
+        }
+        break;
+      }
+      queue_.pop();
+    }
+  }
+  int flags = TFD_TIMER_ABSTIME;
+#ifdef TFD_TIMER_CANCEL_ON_SET
+  flags |= TFD_TIMER_CANCEL_ON_SET;
+#endif
+  if (timerfd_settime(timer_fd_, flags, &spec, nullptr) == -1) {
+    spdlog::error("Scheduler: timerfd_settime failed: {}", strerror(errno));
+  }
+}
+
+void Scheduler::run() {
+  auto applied_slack = std::chrono::milliseconds(-1);
+  while (running_) {
+#ifdef __linux__
+    // Let the kernel merge our wakeups with other timers within the same window
+    if (auto slack = slack_.load(); slack != applied_slack) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(slack).count();
+      prctl(PR_SET_TIMERSLACK, ns > 0 ? ns : 50'000L);
+      applied_slack = slack;
+    }
+#endif
+    armTimer();
+
+    std::array<struct pollfd, 2> fds = {{{timer_fd_, POLLIN, 0}, {event_fd_, POLLIN, 0}}};
+    if (poll(fds.data(), fds.size(), -1) == -1) {
+      if (errno != EINTR) {
+        spdlog::error("Scheduler: poll failed: {}", strerror(errno));
+      }
+      continue;
+    }
+    if (!running_) {
+      break;
+    }
+
+    uint64_t value;
+    if ((fds[1].revents & POLLIN) != 0) {
+      (void)::read(event_fd_, &value, sizeof(value));
+    }
+    bool clock_changed = false;
+    if ((fds[0].revents & POLLIN) != 0 && ::read(timer_fd_, &value, sizeof(value)) == -1 &&
+        errno == ECANCELED) {
+      clock_changed = true;
+    }
+
+    std::lock_guard run_lock(run_mutex_);
+    {
+      std::lock_guard lock(mutex_);
+      auto now = clock::now();
+      if (clock_changed) {
+        spdlog::debug("Scheduler: system clock changed, realigning {} timers", tasks_.size());
+        realign(now);
+      }
+      while (!queue_.empty() && queue_.top().first <= now) {
+        auto [deadline, id] = queue_.top();
+        queue_.pop();
+        auto it = tasks_.find(id);
+        if (it == tasks_.end() || it->second.deadline != deadline) {
+          continue;
+        }
+        auto& task = it->second;
+        due_.push_back(task.cb);
+        // Kept without a deadline, trigger() still fires it
+        if (task.interval == std::chrono::milliseconds::max()) {
+          task.deadline = clock::time_point::max();
+          continue;
+        }
+        task.deadline = nextDeadline(std::max(now, deadline), task.interval);
+        queue_.emplace(task.deadline, id);
+      }
+      if (!due_.empty()) {
+        stats_.wakeups++;
+        stats_.callbacks += due_.size();
+        stats_.last_tick_callbacks = due_.size();
+      }
+    }
+
+    if (!due_.empty()) {
+      spdlog::trace("Scheduler: tick fired {} callbacks", due_.size());
+    }
+    for (const auto& cb : due_) {
+      try {
+        (*cb)();
+      } catch (const std::exception& e) {
+        spdlog::error("Scheduler: timer callback failed: {}", e.what());
+      }
+    }
+    due_.clear();
+  }
+}
+
+}  // namespace waybar::util
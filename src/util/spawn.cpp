@@ -0,0 +1,222 @@
+#include "util/spawn.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/prctl.h>
+#endif
+#ifdef __FreeBSD__
+#include <sys/procctl.h>
+#endif
+
+extern char** environ;
+
+namespace waybar::util {
+
+namespace {
+
+std::atomic<bool> direct_exec = false;
+
+// Characters giving a command a meaning beyond a list of words
+constexpr std::string_view SHELL_CHARS = "|&;<>()$`\\\"'*?[]#~=%{}!\n";
+
+// Reserved words and special builtins, which have no executable to run directly
+constexpr std::string_view SHELL_WORDS =
+    " ! { } case do done elif else esac fi for if in then until while"
+    " . : break continue eval exec exit export readonly return set shift trap unset ";
+
+constexpr std::string_view OUTPUT_NAME_ENV = "WAYBAR_OUTPUT_NAME=";
+
+struct ChildArgs {
+  const char* path;
+  char* const* argv;
+  // Run instead if `path` turns out not to be a binary, nullptr when `path` is the shell
+  char* const* shell_argv;
+  char* const* envp;
+  const SpawnOptions& options;
+  // Set by the child if exec failed, it shares our memory until then
+  int error = 0;
+};
+
+// Runs in the child, on our memory: only async-signal-safe calls, no allocation
+int child(void* data) {
+  auto* args = static_cast<ChildArgs*>(data);
+  const auto& options = args->options;
+
+  // Our handlers must not run in the child before exec resets them
+  struct sigaction action = {};
+  for (int sig = 1; sig < NSIG; sig++) {
+    if (sigaction(sig, nullptr, &action) == 0 && action.sa_handler != SIG_IGN &&
+        action.sa_handler != SIG_DFL) {
+      action.sa_handler = SIG_DFL;
+      action.sa_flags = 0;
+      sigaction(sig, &action, nullptr);
+    }
+  }
+  // Kill the child if Waybar exits
+  if (options.deathsig != 0) {
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, options.deathsig);
+#endif
+#ifdef __FreeBSD__
+    int deathsig = options.deathsig;
+    procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig));
+#endif
+  }
+  setpgid(0, 0);
+  if (options.stdin_fd >= 0) {
+    dup2(options.stdin_fd, STDIN_FILENO);
+  }
+  if (options.stdout_fd >= 0) {
+    dup2(options.stdout_fd, STDOUT_FILENO);
+  }
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigprocmask(SIG_SETMASK, &mask, nullptr);
+
+  execve(args->path, args->argv, args->envp);
+  // A script without a shebang: the shell runs it, as execvp() does
+  if (errno == ENOEXEC && args->shell_argv != nullptr) {
+    execve("/bin/sh", args->shell_argv, args->envp);
+  }
+  args->error = errno;
+  _exit(127);
+}
+
+}  // namespace
+
+void setDirectExec(bool enabled) { direct_exec = enabled; }
+
+bool directExec() { return direct_exec; }
+
+std::optional<std::vector<std::string>> splitSimpleCommand(std::string_view cmd) {
+  if (cmd.find_first_of(SHELL_CHARS) != std::string_view::npos) {
+    return std::nullopt;
+  }
+  std::vector<std::string> words;
+  size_t pos = 0;
+  while ((pos = cmd.find_first_not_of(" \t", pos)) != std::string_view::npos) {
+    auto end = cmd.find_first_of(" \t", pos);
+    words.emplace_back(cmd.substr(pos, end - pos));
+    pos = end;
+  }
+  if (words.empty() || SHELL_WORDS.find(' ' + words.front() + ' ') != std::string_view::npos) {
+    return std::nullopt;
+  }
+  return words;
+}
+
+std::optional<std::string> findExecutable(const std::string& name) {
+  auto executable = [](const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(path.c_str(), X_OK) == 0;
+  };
+  if (name.find('/') != std::string::npos) {
+    return executable(name) ? std::optional(name) : std::nullopt;
+  }
+  // Same default as execvp()
+  const char* env = getenv("PATH");
+  std::string_view path = env != nullptr ? env : "/bin:/usr/bin";
+  size_t pos = 0;
+  while (pos <= path.size()) {
+    auto end = std::min(path.find(':', pos), path.size());
+    auto dir = path.substr(pos, end - pos);
+    // An empty entry is the current directory
+    auto candidate = dir.empty() ? name : std::string(dir) + '/' + name;
+    if (executable(candidate)) {
+      return candidate;
+    }
+    pos = end + 1;
+  }
+  return std::nullopt;
+}
+
+pid_t spawn(const std::string& cmd, const SpawnOptions& options) {
+  std::string path;
+  std::vector<std::string> words;
+  if (options.direct) {
+    if (auto split = splitSimpleCommand(cmd)) {
+      if (auto executable = findExecutable(split->front())) {
+        path = std::move(*executable);
+        words = std::move(*split);
+      }
+    }
+  }
+  std::string shell_cmd = cmd;
+  std::vector<char*> shell_argv = {const_cast<char*>("sh"), const_cast<char*>("-c"),
+                                   shell_cmd.data(), nullptr};
+  const bool direct = !path.empty();
+  if (!direct) {
+    path = "/bin/sh";
+  }
+  std::vector<char*> argv;
+  if (direct) {
+    argv.reserve(words.size() + 1);
+    for (auto& word : words) {
+      argv.push_back(word.data());
+    }
+    argv.push_back(nullptr);
+  } else {
+    argv = shell_argv;
+  }
+
+  // The child can't setenv() on our memory, build its environment here
+  std::string output_name;
+  std::vector<char*> envp;
+  if (!options.output_name.empty()) {
+    output_name = std::string(OUTPUT_NAME_ENV) + options.output_name;
+    for (char** env = environ; *env != nullptr; env++) {
+      if (!std::string_view(*env).starts_with(OUTPUT_NAME_ENV)) {
+        envp.push_back(*env);
+      }
+    }
+    envp.push_back(output_name.data());
+    envp.push_back(nullptr);
+  }
+
+  ChildArgs args{path.c_str(), argv.data(), direct ? shell_argv.data() : nullptr,
+                 envp.empty() ? environ : envp.data(), options};
+
+  // Keep signals from reaching the child until it reset our handlers
+  sigset_t all;
+  sigset_t previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+#ifdef __linux__
+  constexpr size_t STACK_SIZE = 64 * 1024;
+  std::unique_ptr<char[]> stack(new char[STACK_SIZE]);
+  // The stack grows down on every architecture Waybar runs on
+  pid_t pid = clone(&child, stack.get() + STACK_SIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+#else
+  pid_t pid = vfork();
+  if (pid == 0) {
+    child(&args);
+  }
+#endif
+  int error = errno;
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+  if (pid < 0) {
+    errno = error;
+    return -1;
+  }
+  if (args.error != 0) {
+    waitpid(pid, nullptr, 0);
+    errno = args.error;
+    return -1;
+  }
+  return pid;
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,488 @@
+#include "util/system_sampler.hpp"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "util/sleeper_thread.hpp"
+
+namespace waybar::util {
+
+namespace {
+constexpr const char* NETDEV_FILE = "/proc/net/dev";
+
+size_t fieldIndex(SystemSampler::Field field) {
+  return static_cast<size_t>(__builtin_ctz(static_cast<uint32_t>(field)));
+}
+
+/**
+ * File kept open and re-read with pread() into a reused buffer.
+ */
+class PersistentFile {
+ public:
+  explicit PersistentFile(const std::string& path) : fd_(open(path.c_str(), O_RDONLY | O_CLOEXEC)) {
+    buffer_.resize(4096);
+  }
+  ~PersistentFile() {
+    if (fd_ != -1) {
+      close(fd_);
+    }
+  }
+  PersistentFile(const PersistentFile&) = delete;
+  PersistentFile& operator=(const PersistentFile&) = delete;
+
+  // Whole content of the file, or nullopt if it can't be read
+  std::optional<std::string_view> read() {
+    if (fd_ == -1) {
+      return std::nullopt;
+    }
+    size_t len = 0;
+    while (true) {
+      if (len == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+      }
+      auto n = pread(fd_, buffer_.data() + len, buffer_.size() - len, static_cast<off_t>(len));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return std::nullopt;
+      }
+      if (n == 0) {
+        break;
+      }
+      len += n;
+    }
+    return std::string_view(buffer_.data(), len);
+  }
+
+ private:
+  int fd_;
+  std::vector<char> buffer_;
+};
+
+bool sameUsage(const struct statvfs& a, const struct statvfs& b) {
+  return a.f_blocks == b.f_blocks && a.f_bfree == b.f_bfree && a.f_bavail == b.f_bavail &&
+         a.f_frsize == b.f_frsize;
+}
+
+void parseNetDev(std::string_view data, std::map<std::string, SystemSampler::NetDev>& netdev) {
+  // Skip the headers (first two lines)
+  for (int i = 0; i < 2; i++) {
+    auto eol = data.find('\n');
+    data = eol == std::string_view::npos ? std::string_view() : data.substr(eol + 1);
+  }
+  while (!data.empty()) {
+    auto eol = data.find('\n');
+    auto line = data.substr(0, eol);
+    data = eol == std::string_view::npos ? std::string_view() : data.substr(eol + 1);
+
+    // "  eth0: 1234 ..." the interface name is padded on the left
+    auto colon = line.find(':');
+    if (colon == std::string_view::npos) {
+      continue;
+    }
+    auto name = line.substr(0, colon);
+    name.remove_prefix(std::min(name.find_first_not_of(' '), name.size()));
+
+    // The rest of the line consists of whitespace separated counts divided into two groups
+    // (receive and transmit) of 8 columns each. Only the first column of each group, the byte
+    // count, is used.
+    const char* p = line.data() + colon + 1;
+    const char* const end = line.data() + line.size();
+    unsigned long long columns[9] = {};
+    for (auto& column : columns) {
+      while (p < end && *p == ' ') {
+        ++p;
+      }
+      p = std::from_chars(p, end, column).ptr;
+    }
+    netdev[std::string(name)] = {columns[0], columns[8]};
+  }
+}
+}  // namespace
+
+class SystemSampler::Group {
+ public:
+  explicit Group(std::chrono::milliseconds interval) : interval_(interval) {}
+  ~Group() { timer_.reset(); }
+
+  // Sample now, then at every tick. The scheduler only wakes the worker: a statvfs() stuck on a
+  // hung mount holds up this group, not every clock and interval module.
+  void start() {
+    thread_ = [this] {
+      sample();
+      thread_.sleep();
+    };
+    timer_ = Scheduler::inst().schedule(
+        interval_, [this] { thread_.wake_up(); }, false);
+  }
+
+  uint64_t add(Request request, Dispatcher* dp) {
+    std::lock_guard lock(mutex_);
+    bool new_sources = false;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+      if ((request.fields & (1u << i)) != 0 && field_refs_[i]++ == 0) {
+        new_sources = true;
+      }
+    }
+    for (const auto& path : request.inputs) {
+      if (input_refs_[path]++ == 0) {
+        new_sources = true;
+      }
+    }
+    for (const auto& path : request.mounts) {
+      if (mount_refs_[path]++ == 0) {
+        new_sources = true;
+      }
+    }
+    if (!read_stat_ && request.read_stat) {
+      read_stat_ = std::move(request.read_stat);
+    }
+    if (!read_meminfo_ && request.read_meminfo) {
+      read_meminfo_ = std::move(request.read_meminfo);
+    }
+    auto id = next_id_++;
+    subscribers_.push_back({id, request.fields, std::move(request.inputs),
+                            std::move(request.mounts), dp});
+    if (new_sources) {
+      sources_version_++;
+    }
+    if (timer_ && new_sources) {
+      // Sample the new sources now rather than at the next tick
+      thread_.wake_up();
+    } else if (current_ && dp != nullptr) {
+      dp->emit();
+    }
+    return id;
+  }
+
+  // Returns true if the group has no subscribers left
+  bool remove(uint64_t id) {
+    std::lock_guard lock(mutex_);
+    auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
+                           [id](const auto& subscriber) { return subscriber.id == id; });
+    if (it == subscribers_.end()) {
+      return subscribers_.empty();
+    }
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+      if ((it->fields & (1u << i)) != 0) {
+        field_refs_[i]--;
+      }
+    }
+    for (const auto& path : it->inputs) {
+      if (--input_refs_[path] == 0) {
+        input_refs_.erase(path);
+        sources_version_++;
+      }
+    }
+    for (const auto& path : it->mounts) {
+      if (--mount_refs_[path] == 0) {
+        mount_refs_.erase(path);
+        sources_version_++;
+      }
+    }
+    subscribers_.erase(it);
+    return subscribers_.empty();
+  }
+
+  std::shared_ptr<const Snapshot> snapshot() const {
+    std::lock_guard lock(mutex_);
+    return current_;
+  }
+
+ private:
+  struct Subscriber {
+    uint64_t id;
+    uint32_t fields;
+    std::vector<std::string> inputs;
+    std::vector<std::string> mounts;
+    Dispatcher* dp;
+  };
+
+  // What the worker reads, copied from the subscriptions when they change
+  struct Sources {
+    uint64_t version = 0;
+    uint32_t fields = 0;
+    std::vector<std::string> inputs;
+    std::vector<std::string> mounts;
+    std::function<void(CpuTimes&)> read_stat;
+    std::function<void(Meminfo&)> read_meminfo;
+
+    bool wants(Field field) const { return (fields & field) != 0; }
+  };
+
+  // Runs on the worker. The lock is only held to pick the sources and to publish: the reads
+  // happen without it, so that snapshot() and (un)subscribing never wait for the kernel.
+  void sample() {
+    std::shared_ptr<Snapshot> next;
+    std::shared_ptr<const Snapshot> current;
+    {
+      std::lock_guard lock(mutex_);
+      if (sources_.version != sources_version_) {
+        updateSources();
+      }
+      // Reuse the storage of the snapshot before the current one once no module holds it anymore
+      if (retired_ && retired_.use_count() == 1) {
+        next = std::move(retired_);
+      }
+      current = current_;
+    }
+    if (!next) {
+      next = std::make_shared<Snapshot>();
+    }
+    const Snapshot* prev = current.get();
+    const auto& sources = sources_;
+    next->version = prev == nullptr ? 1 : prev->version + 1;
+    next->taken = std::chrono::steady_clock::now();
+    next->changed = prev == nullptr ? decltype(next->changed){} : prev->changed;
+
+    uint32_t changed = 0;
+    auto update = [&](Field field, bool field_changed) {
+      if (prev == nullptr || field_changed) {
+        next->changed[fieldIndex(field)] = next->version;
+        changed |= field;
+      }
+    };
+
+    if (sources.wants(STAT) && sources.read_stat) {
+      try {
+        sources.read_stat(next->stat);
+      } catch (const std::exception& e) {
+        spdlog::error("Sampling cpu times failed: {}", e.what());
+        next->stat = prev != nullptr ? prev->stat : CpuTimes();
+      }
+      update(STAT, prev == nullptr || next->stat.total != prev->stat.total ||
+                       next->stat.idle != prev->stat.idle);
+    }
+    if (sources.wants(MEMINFO) && sources.read_meminfo) {
+      try {
+        sources.read_meminfo(next->meminfo);
+      } catch (const std::exception& e) {
+        spdlog::error("Sampling memory failed: {}", e.what());
+        next->meminfo = prev != nullptr ? prev->meminfo : Meminfo();
+      }
+      update(MEMINFO, prev == nullptr || next->meminfo != prev->meminfo);
+    }
+    if (sources.wants(LOADAVG)) {
+      std::array<double, 3> load;
+      if (getloadavg(load.data(), 3) != -1) {
+        next->loadavg = load;
+      } else {
+        next->loadavg.reset();
+      }
+      update(LOADAVG, prev == nullptr || next->loadavg != prev->loadavg);
+    }
+    next->inputs.clear();
+    if (sources.wants(INPUTS)) {
+      bool inputs_changed = false;
+      for (const auto& path : sources.inputs) {
+        auto& file = input_files_[path];
+        if (!file) {
+          file = std::make_unique<PersistentFile>(path);
+        }
+        auto content = file->read();
+        int64_t value = 0;
+        if (!content || std::from_chars(content->data(), content->data() + content->size(), value)
+                                .ec != std::errc()) {
+          continue;
+        }
+        Input input{value, next->version};
+        if (prev != nullptr) {
+          auto it = prev->inputs.find(path);
+          if (it != prev->inputs.end() && it->second.value == value) {
+            input.changed = it->second.changed;
+          }
+        }
+        inputs_changed |= input.changed == next->version;
+        next->inputs.emplace(path, input);
+      }
+      update(INPUTS, inputs_changed || prev == nullptr || prev->inputs.size() != next->inputs.size());
+    }
+    next->mounts.clear();
+    if (sources.wants(MOUNTS)) {
+      bool mounts_changed = false;
+      for (const auto& path : sources.mounts) {
+        Mount mount{{}, next->version};
+        if (statvfs(path.c_str(), &mount.stats) != 0) {
+          continue;
+        }
+        if (prev != nullptr) {
+          auto it = prev->mounts.find(path);
+          if (it != prev->mounts.end() && sameUsage(it->second.stats, mount.stats)) {
+            mount.changed = it->second.changed;
+          }
+        }
+        mounts_changed |= mount.changed == next->version;
+        next->mounts.emplace(path, mount);
+      }
+      update(MOUNTS, mounts_changed || prev == nullptr || prev->mounts.size() != next->mounts.size());
+    }
+    if (sources.wants(NETDEV)) {
+      if (!netdev_file_) {
+        netdev_file_ = std::make_unique<PersistentFile>(NETDEV_FILE);
+      }
+      next->netdev.clear();
+      if (auto content = netdev_file_->read()) {
+        parseNetDev(*content, next->netdev);
+      } else {
+        spdlog::warn("Failed to read netdev file {}", NETDEV_FILE);
+      }
+      update(NETDEV, prev == nullptr || next->netdev != prev->netdev);
+    }
+
+    std::lock_guard lock(mutex_);
+    retired_ = std::const_pointer_cast<Snapshot>(std::move(current_));
+    current_ = std::move(next);
+
+    for (const auto& subscriber : subscribers_) {
+      if (subscriber.dp != nullptr && (subscriber.fields & changed) != 0 &&
+          touches(subscriber, changed)) {
+        subscriber.dp->emit();
+      }
+    }
+  }
+
+  // Copy the subscriptions' sources for the worker, under the lock
+  void updateSources() {
+    sources_.version = sources_version_;
+    sources_.fields = 0;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+      if (field_refs_[i] > 0) {
+        sources_.fields |= 1u << i;
+      }
+    }
+    sources_.inputs.clear();
+    for (const auto& [path, refs] : input_refs_) {
+      sources_.inputs.push_back(path);
+    }
+    sources_.mounts.clear();
+    for (const auto& [path, refs] : mount_refs_) {
+      sources_.mounts.push_back(path);
+    }
+    if (!sources_.read_stat) {
+      sources_.read_stat = read_stat_;
+    }
+    if (!sources_.read_meminfo) {
+      sources_.read_meminfo = read_meminfo_;
+    }
+    std::erase_if(input_files_, [this](const auto& entry) {
+      return !input_refs_.contains(entry.first);
+    });
+  }
+
+  // Whether a change of the INPUTS or MOUNTS field concerns the paths of `subscriber`
+  bool touches(const Subscriber& subscriber, uint32_t changed) const {
+    if ((subscriber.fields & changed & ~(INPUTS | MOUNTS)) != 0) {
+      return true;
+    }
+    auto changed_now = [this](const auto& entries, const std::string& path) {
+      auto it = entries.find(path);
+      return it == entries.end() || it->second.changed == current_->version;
+    };
+    return std::ranges::any_of(subscriber.inputs,
+                               [&](const auto& path) {
+                                 return changed_now(current_->inputs, path);
+                               }) ||
+           std::ranges::any_of(subscriber.mounts, [&](const auto& path) {
+             return changed_now(current_->mounts, path);
+           });
+  }
+
+  const std::chrono::milliseconds interval_;
+  mutable std::mutex mutex_;
+  std::vector<Subscriber> subscribers_;
+  uint64_t next_id_ = 1;
+  std::array<size_t, FIELD_COUNT> field_refs_{};
+  std::map<std::string, size_t> input_refs_;
+  std::map<std::string, size_t> mount_refs_;
+  // Bumped when a source is added or removed, ahead of `sources_` until the worker copied them
+  uint64_t sources_version_ = 1;
+  // Worker only, but for updateSources()
+  Sources sources_;
+  std::map<std::string, std::unique_ptr<PersistentFile>> input_files_;
+  std::unique_ptr<PersistentFile> netdev_file_;
+  std::function<void(CpuTimes&)> read_stat_;
+  std::function<void(Meminfo&)> read_meminfo_;
+  std::shared_ptr<const Snapshot> current_;
+  std::shared_ptr<Snapshot> retired_;
+  Scheduler::Subscription timer_;
+  // Last, so that it stops before the members it samples into go away
+  SleeperThread thread_;
+};
+
+bool SystemSampler::Snapshot::changedSince(uint32_t fields, uint64_t version) const {
+  for (size_t i = 0; i < FIELD_COUNT; i++) {
+    if ((fields & (1u << i)) != 0 && changed[i] > version) {
+      return true;
+    }
+  }
+  return false;
+}
+
+SystemSampler::Subscription::Subscription(Subscription&& other) noexcept
+    : group_(std::move(other.group_)), id_(other.id_) {}
+
+SystemSampler::Subscription& SystemSampler::Subscription::operator=(Subscription&& other) noexcept {
+  if (this != &other) {
+    reset();
+    group_ = std::move(other.group_);
+    id_ = other.id_;
+  }
+  return *this;
+}
+
+void SystemSampler::Subscription::reset() {
+  if (group_) {
+    SystemSampler::inst().release(group_, id_);
+    group_.reset();
+  }
+}
+
+std::shared_ptr<const SystemSampler::Snapshot> SystemSampler::Subscription::snapshot() const {
+  return group_ ? group_->snapshot() : nullptr;
+}
+
+SystemSampler& SystemSampler::inst() {
+  // Leaked on purpose, modules may unsubscribe from static destructors
+  static auto* sampler = new SystemSampler();
+  return *sampler;
+}
+
+SystemSampler::Subscription SystemSampler::subscribe(std::chrono::milliseconds interval,
+                                                     Request request, Dispatcher* dp) {
+  std::lock_guard lock(mutex_);
+  auto& group = groups_[interval];
+  bool created = !group;
+  if (created) {
+    group = std::make_shared<Group>(interval);
+  }
+  auto id = group->add(std::move(request), dp);
+  if (created) {
+    group->start();
+  }
+  return {group, id};
+}
+
+size_t SystemSampler::groups() const {
+  std::lock_guard lock(mutex_);
+  return groups_.size();
+}
+
+void SystemSampler::release(const std::shared_ptr<Group>& group, uint64_t id) {
+  std::lock_guard lock(mutex_);
+  if (!group->remove(id)) {
+    return;
+  }
+  // The group (and its timer) goes away with the last subscription handle, outside of the lock
+  std::erase_if(groups_, [&group](const auto& entry) { return entry.second == group; });
+}
+
+}  // namespace waybar::util
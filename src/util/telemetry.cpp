@@ -0,0 +1,178 @@
+#include "util/telemetry.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "util/scheduler.hpp"
+
+namespace waybar::util {
+
+namespace {
+thread_local std::shared_ptr<ModuleStats> current_stats;
+}  // namespace
+
+void Histogram::record(std::chrono::steady_clock::duration duration) {
+  auto us = static_cast<uint64_t>(std::max<int64_t>(
+      0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+  auto bucket = std::min<size_t>(std::bit_width(us), BUCKETS - 1);
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_us_.fetch_add(us, std::memory_order_relaxed);
+  auto max = max_us_.load(std::memory_order_relaxed);
+  while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+std::chrono::microseconds Histogram::percentile(double quantile) const {
+  uint64_t total = count_;
+  if (total == 0) {
+    return std::chrono::microseconds(0);
+  }
+  auto rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS - 1; i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(std::chrono::microseconds(uint64_t{1} << i), max());
+    }
+  }
+  return max();
+}
+
+Json::Value Histogram::toJson() const {
+  Json::Value json(Json::objectValue);
+  json["count"] = static_cast<Json::UInt64>(count());
+  json["sum_us"] = static_cast<Json::UInt64>(sum().count());
+  json["max_us"] = static_cast<Json::UInt64>(max().count());
+  json["p50_us"] = static_cast<Json::UInt64>(percentile(0.5).count());
+  json["p99_us"] = static_cast<Json::UInt64>(percentile(0.99).count());
+  // Upper bound in µs of each non-empty bucket, with its count
+  Json::Value buckets(Json::objectValue);
+  for (size_t i = 0; i < BUCKETS; i++) {
+    if (auto n = buckets_[i].load(); n > 0) {
+      auto key = i == BUCKETS - 1 ? "inf" : std::to_string(uint64_t{1} << i);
+      buckets[key] = static_cast<Json::UInt64>(n);
+    }
+  }
+  json["buckets"] = buckets;
+  return json;
+}
+
+Json::Value ModuleStats::toJson() const {
+  Json::Value json(Json::objectValue);
+  json["name"] = name;
+  json["output"] = output;
+  json["update"] = update.toJson();
+  json["dispatch_latency"] = dispatch_latency.toJson();
+  json["worker"] = worker.toJson();
+  json["exec"] = exec.toJson();
+  json["forks"] = static_cast<Json::UInt64>(forks.load());
+  json["exec_hits"] = static_cast<Json::UInt64>(exec_hits.load());
+  json["exec_joined"] = static_cast<Json::UInt64>(exec_joined.load());
+  json["exec_misses"] = static_cast<Json::UInt64>(exec_misses.load());
+  json["dropped"] = static_cast<Json::UInt64>(dropped.load());
+  json["label_applied"] = static_cast<Json::UInt64>(label_applied.load());
+  json["label_skipped"] = static_cast<Json::UInt64>(label_skipped.load());
+  return json;
+}
+
+Telemetry& Telemetry::inst() {
+  static auto* inst = new Telemetry();
+  return *inst;
+}
+
+std::shared_ptr<ModuleStats> Telemetry::create(std::string name, std::string output) {
+  auto stats = std::make_shared<ModuleStats>(std::move(name), std::move(output));
+  std::lock_guard lock(mutex_);
+  std::erase_if(modules_, [](const auto& module) { return module.expired(); });
+  modules_.push_back(stats);
+  return stats;
+}
+
+const std::shared_ptr<ModuleStats>& Telemetry::current() { return current_stats; }
+
+Telemetry::Scope::Scope(std::shared_ptr<ModuleStats> stats)
+    : previous_(std::exchange(current_stats, std::move(stats))) {}
+
+Telemetry::Scope::~Scope() { current_stats = std::move(previous_); }
+
+std::vector<std::shared_ptr<ModuleStats>> Telemetry::modules() const {
+  std::vector<std::shared_ptr<ModuleStats>> modules;
+  std::lock_guard lock(mutex_);
+  for (const auto& module : modules_) {
+    if (auto stats = module.lock()) {
+      modules.push_back(std::move(stats));
+    }
+  }
+  return modules;
+}
+
+Json::Value Telemetry::toJson() const {
+  Json::Value json(Json::objectValue);
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  json["timestamp"] = static_cast<Json::Int64>(
+      std::chrono::duration_cast<std::chrono::seconds>(now).count());
+  // Ticks of the timer shared by the interval modules
+  auto ticks = Scheduler::inst().stats();
+  Json::Value scheduler(Json::objectValue);
+  scheduler["wakeups"] = static_cast<Json::UInt64>(ticks.wakeups);
+  scheduler["callbacks"] = static_cast<Json::UInt64>(ticks.callbacks);
+  scheduler["last_tick_callbacks"] = static_cast<Json::UInt64>(ticks.last_tick_callbacks);
+  scheduler["subscriptions"] = static_cast<Json::UInt64>(ticks.subscriptions);
+  json["scheduler"] = scheduler;
+  Json::Value modules(Json::arrayValue);
+  for (const auto& stats : this->modules()) {
+    modules.append(stats->toJson());
+  }
+  json["modules"] = modules;
+  return json;
+}
+
+void Telemetry::log() const {
+  auto ticks = Scheduler::inst().stats();
+  spdlog::info("scheduler: {} wakeups, {} callbacks ({} on the last tick), {} subscriptions",
+               ticks.wakeups, ticks.callbacks, ticks.last_tick_callbacks, ticks.subscriptions);
+  auto modules = this->modules();
+  auto cost = [](const auto& stats) { return stats->update.sum() + stats->worker.sum(); };
+  std::ranges::sort(modules, [&cost](const auto& a, const auto& b) { return cost(a) > cost(b); });
+  for (const auto& stats : modules) {
+    spdlog::info(
+        "{}{}{}: update {} p50 {}µs p99 {}µs max {}µs, latency p99 {}µs, worker {} p99 {}µs, "
+        "exec {} p99 {}µs (cache {} hits, {} joined, {} misses), {} forks, {} dropped, "
+        "{} label changes ({} skipped)",
+        stats->name, stats->output.empty() ? "" : "@", stats->output, stats->update.count(),
+        stats->update.percentile(0.5).count(), stats->update.percentile(0.99).count(),
+        stats->update.max().count(), stats->dispatch_latency.percentile(0.99).count(),
+        stats->worker.count(), stats->worker.percentile(0.99).count(), stats->exec.count(),
+        stats->exec.percentile(0.99).count(), stats->exec_hits.load(), stats->exec_joined.load(),
+        stats->exec_misses.load(), stats->forks.load(), stats->dropped.load(),
+        stats->label_applied.load(), stats->label_skipped.load());
+  }
+}
+
+void Telemetry::write(const std::string& path) const {
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  auto tmp = path + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::trunc);
+    if (!file) {
+      throw std::runtime_error("Can't open " + tmp);
+    }
+    file << Json::writeString(builder, toJson()) << '\n';
+    if (!file) {
+      throw std::runtime_error("Can't write " + tmp);
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Can't rename " + tmp + " to " + path);
+  }
+}
+
+}  // namespace waybar::util
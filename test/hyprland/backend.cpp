@@ -3,6 +3,12 @@
 #else
 #include <catch2/catch.hpp>
 #endif
+#if __has_include(<catch2/benchmark/catch_benchmark.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define WAYBAR_HAVE_CATCH_BENCHMARK
+#endif
+
+#include <future>
 
 #include "fixtures/IPCTestFixture.hpp"
 
@@ -57,3 +63,242 @@ TEST_CASE_METHOD(IPCTestFixture, "getSocket1Reply throws on no socket", "[getSoc
 
   CHECK_THROWS(getSocket1Reply(request));
 }
+
+TEST_CASE_METHOD(IPCTestFixture, "Queries are shared until the next event", "[queryCache]") {
+  Socket1Server server(tempDir, instanceSig, R"([{"id": 1}])");
+  setQueryCacheEnabled(true);
+
+  auto first = getSocket1JsonReplyShared("workspaces");
+  auto second = getSocket1JsonReplyShared("workspaces");
+  REQUIRE(first == second);
+  REQUIRE((*first)[0]["id"].asInt() == 1);
+  REQUIRE(getSocket1JsonReply("workspaces") == *first);
+  REQUIRE(server.queries == 1);
+
+  getSocket1JsonReplyShared("monitors");
+  REQUIRE(server.queries == 2);
+
+  nextGeneration();
+  REQUIRE(getSocket1JsonReplyShared("workspaces") != first);
+  REQUIRE(server.queries == 3);
+
+  setQueryCacheEnabled(false);
+  getSocket1JsonReplyShared("workspaces");
+  getSocket1JsonReplyShared("workspaces");
+  REQUIRE(server.queries == 5);
+}
+
+TEST_CASE_METHOD(IPCTestFixture, "Concurrent queries wait for the running one",
+                 "[queryCache]") {
+  Socket1Server server(tempDir, instanceSig, R"({"id": 2})", std::chrono::milliseconds(100));
+  setQueryCacheEnabled(true);
+
+  std::vector<std::shared_ptr<const Json::Value>> replies(4);
+  std::vector<std::thread> threads;
+  for (auto& reply : replies) {
+    threads.emplace_back([this, &reply] { reply = getSocket1JsonReplyShared("activeworkspace"); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(server.queries == 1);
+  for (const auto& reply : replies) {
+    REQUIRE(reply == replies.front());
+  }
+}
+
+TEST_CASE_METHOD(IPCTestFixture, "Batch replies are split by their brackets", "[batch]") {
+  auto replies = splitBatchReply(R"({"name": "a}\"]"}
+
+[{"id": [1, 2]}, {}]
+
+
+{}ok)");
+  REQUIRE(replies.size() == 3);
+  REQUIRE(replies[0] == R"({"name": "a}\"]"})");
+  REQUIRE(replies[1] == R"([{"id": [1, 2]}, {}])");
+  REQUIRE(replies[2] == "{}");
+}
+
+TEST_CASE_METHOD(IPCTestFixture, "Queries not shared yet are sent as one batch", "[batch]") {
+  Socket1Server server(tempDir, instanceSig, R"({"id": 3})");
+
+  auto replies = getSocket1JsonReplies({"monitors", "workspaces", "activeworkspace"});
+  REQUIRE(replies.size() == 3);
+  for (const auto& reply : replies) {
+    REQUIRE((*reply)["id"].asInt() == 3);
+  }
+  REQUIRE(server.queries == 1);
+
+  setQueryCacheEnabled(true);
+  auto monitors = getSocket1JsonReplyShared("monitors");
+  REQUIRE(server.queries == 2);
+  replies = getSocket1JsonReplies({"monitors", "workspaces", "activeworkspace"});
+  REQUIRE(replies[0] == monitors);
+  REQUIRE(server.queries == 3);
+  getSocket1JsonReplies({"workspaces", "activeworkspace"});
+  REQUIRE(server.queries == 3);
+}
+
+namespace {
+struct EventRecorder : public hyprland::EventHandler {
+  void onEvent(const std::string& ev) override {
+    std::lock_guard lock(mutex);
+    events.push_back(ev);
+  }
+
+  size_t waitFor(size_t count) {
+    for (int i = 0; i < 500; i++) {
+      {
+        std::lock_guard lock(mutex);
+        if (events.size() >= count) {
+          return events.size();
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::lock_guard lock(mutex);
+    return events.size();
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> events;
+};
+}  // namespace
+
+TEST_CASE("Socket2 events are dispatched by name without delay", "[socketListener]") {
+  Socket2Server server(fs::temp_directory_path() / "hypr_test_socket2", "instance_sig");
+  EventRecorder workspaces;
+  EventRecorder windows;
+  {
+    hyprland::IPC ipc;
+    ipc.registerForIPC("workspacev2", &workspaces);
+    ipc.registerForIPC("openwindow", &windows);
+    int client = server.accept();
+    REQUIRE(client != -1);
+
+    // An event split across writes, then a burst far above 1000 events/s
+    std::string partial = "workspacev2>>1,";
+    REQUIRE(write(client, partial.data(), partial.size()) == static_cast<ssize_t>(partial.size()));
+    std::string events = "one\nactivewindowv2>>0x1\n";
+    for (int i = 0; i < 5000; i++) {
+      events += "openwindow>>" + std::to_string(i) + ",1,kitty,kitty\n";
+    }
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(write(client, events.data(), events.size()) == static_cast<ssize_t>(events.size()));
+
+    REQUIRE(windows.waitFor(5000) == 5000);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    REQUIRE(workspaces.waitFor(1) == 1);
+    REQUIRE(workspaces.events.front() == "workspacev2>>1,one");
+    REQUIRE(windows.events.back() == "openwindow>>4999,1,kitty,kitty");
+
+    ipc.unregisterForIPC(&windows);
+    std::string more = "openwindow>>5000,1,kitty,kitty\nworkspacev2>>2,two\n";
+    REQUIRE(write(client, more.data(), more.size()) == static_cast<ssize_t>(more.size()));
+    REQUIRE(workspaces.waitFor(2) == 2);
+    REQUIRE(windows.events.size() == 5000);
+    close(client);
+  }
+}
+
+TEST_CASE("Socket2 listener stops while waiting for events", "[socketListener]") {
+  Socket2Server server(fs::temp_directory_path() / "hypr_test_socket2", "instance_sig");
+  auto ipc = std::make_unique<hyprland::IPC>();
+  int client = server.accept();
+  REQUIRE(client != -1);
+  auto start = std::chrono::steady_clock::now();
+  ipc.reset();
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+  close(client);
+}
+
+TEST_CASE("State is updated from events and read again after drift", "[getState]") {
+  auto runtimeDir = fs::temp_directory_path() / "hypr_test_state";
+  Socket2Server events(runtimeDir, "instance_sig");
+  // One reply serving as monitors, workspaces and clients
+  Socket1Server queries(runtimeDir, "instance_sig",
+                        R"([{"id": 1, "name": "1", "monitor": "1", "focused": true,
+                            "activeWorkspace": {"id": 1}, "windows": 1, "address": "0xa1",
+                            "workspace": {"id": 1, "name": "1"}, "class": "kitty",
+                            "title": "~", "mapped": true}])");
+  EventRecorder titles;
+  hyprland::IPC ipc;
+  ipc.registerForIPC("windowtitlev2", &titles);
+  int client = events.accept();
+  REQUIRE(client != -1);
+  // The state is only kept once the listener is connected
+  while (ipc.getState() != ipc.getState()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  auto queried = queries.queries.load();
+  REQUIRE(ipc.getState()->findClient("a1")->title == "~");
+
+  // A snapshot a reader holds doesn't change, the next one does
+  auto snapshot = ipc.getState();
+  std::string title = "windowtitlev2>>a1,vim\n";
+  REQUIRE(write(client, title.data(), title.size()) == static_cast<ssize_t>(title.size()));
+  REQUIRE(titles.waitFor(1) == 1);
+  REQUIRE(snapshot->findClient("a1")->title == "~");
+  REQUIRE(ipc.getState()->findClient("a1")->title == "vim");
+  REQUIRE(queries.queries == queried);
+
+  // Without readers, it is updated in place
+  snapshot.reset();
+  const auto* inPlace = ipc.getState().get();
+  title = "windowtitlev2>>a1,nvim\n";
+  REQUIRE(write(client, title.data(), title.size()) == static_cast<ssize_t>(title.size()));
+  REQUIRE(titles.waitFor(2) == 2);
+  REQUIRE(ipc.getState().get() == inPlace);
+  REQUIRE(ipc.getState()->findClient("a1")->title == "nvim");
+
+  std::string unknown = "windowtitlev2>>ffff,vim\n";
+  REQUIRE(write(client, unknown.data(), unknown.size()) == static_cast<ssize_t>(unknown.size()));
+  REQUIRE(titles.waitFor(3) == 3);
+  REQUIRE(ipc.getState()->findClient("a1")->title == "~");
+  REQUIRE(queries.queries == queried + 1);
+  close(client);
+}
+
+TEST_CASE("Reading the state doesn't hold up events", "[getState]") {
+  auto runtimeDir = fs::temp_directory_path() / "hypr_test_state_slow";
+  Socket2Server events(runtimeDir, "instance_sig");
+  Socket1Server queries(runtimeDir, "instance_sig", "[]", std::chrono::milliseconds(500));
+  EventRecorder titles;
+  hyprland::IPC ipc;
+  ipc.registerForIPC("windowtitlev2", &titles);
+  int client = events.accept();
+  REQUIRE(client != -1);
+
+  auto reading = std::async(std::launch::async, [&ipc] { return ipc.getState(); });
+  while (queries.queries == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::string title = "windowtitlev2>>a1,vim\n";
+  REQUIRE(write(client, title.data(), title.size()) == static_cast<ssize_t>(title.size()));
+  REQUIRE(titles.waitFor(1) == 1);
+  REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+
+  // Read before the event: returned, but not kept
+  REQUIRE(reading.get() != nullptr);
+  auto queried = queries.queries.load();
+  ipc.getState();
+  REQUIRE(queries.queries > queried);
+  close(client);
+}
+
+#ifdef WAYBAR_HAVE_CATCH_BENCHMARK
+TEST_CASE_METHOD(IPCTestFixture, "Benchmark workspace switch queries", "[!benchmark][batch]") {
+  Socket1Server server(tempDir, instanceSig, R"([{"id": 1, "name": "1", "monitor": "DP-1"}])");
+
+  BENCHMARK("monitors, workspaces and activeworkspace one by one") {
+    getSocket1JsonReply("monitors");
+    getSocket1JsonReply("workspaces");
+    return getSocket1JsonReply("activeworkspace");
+  };
+  BENCHMARK("monitors, workspaces and activeworkspace batched") {
+    return getSocket1JsonReplies({"monitors", "workspaces", "activeworkspace"});
+  };
+}
+#endif
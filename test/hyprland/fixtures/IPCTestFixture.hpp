@@ -1,3 +1,11 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "modules/hyprland/backend.hpp"
 
 namespace fs = std::filesystem;
@@ -8,6 +16,8 @@ class IPCTestFixture : public hyprland::IPC {
   IPCTestFixture() : IPC() { IPC::socketFolder_ = ""; }
   ~IPCTestFixture() { fs::remove_all(tempDir); }
 
+  static void resetSocketFolder() { IPC::socketFolder_ = ""; }
+
  protected:
   const char* instanceSig = "instance_sig";
   fs::path tempDir = fs::temp_directory_path() / "hypr_test";
@@ -23,3 +33,93 @@ class IPCMock : public IPCTestFixture {
  protected:
   const char* instanceSig = "instance_sig";
 };
+
+// Answers every request on a socket1 in a temporary instance folder with `reply`, after `delay`
+class Socket1Server {
+ public:
+  Socket1Server(const fs::path& runtimeDir, const char* instanceSig, std::string reply,
+                std::chrono::milliseconds delay = {})
+      : reply_(std::move(reply)), delay_(delay) {
+    fs::create_directories(runtimeDir / "hypr" / instanceSig);
+    setenv("XDG_RUNTIME_DIR", runtimeDir.c_str(), 1);
+    setenv("HYPRLAND_INSTANCE_SIGNATURE", instanceSig, 1);
+    auto path = runtimeDir / "hypr" / instanceSig / ".socket.sock";
+    fs::remove(path);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(fd_, 16);
+    thread_ = std::thread([this] {
+      int client;
+      while ((client = accept(fd_, nullptr, nullptr)) != -1) {
+        queries++;
+        std::array<char, 256> buffer;
+        auto n = read(client, buffer.data(), buffer.size());
+        std::string request(buffer.data(), std::max<ssize_t>(n, 0));
+        // One reply per request of a batch, separated as Hyprland does
+        std::string reply = reply_;
+        if (request.starts_with("[[BATCH]]")) {
+          for (auto c : request) {
+            if (c == ';') {
+              reply += "\n\n\n" + reply_;
+            }
+          }
+        }
+        std::this_thread::sleep_for(delay_);
+        write(client, reply.data(), reply.size());
+        close(client);
+      }
+    });
+  }
+
+  ~Socket1Server() {
+    shutdown(fd_, SHUT_RDWR);
+    close(fd_);
+    thread_.join();
+    unsetenv("HYPRLAND_INSTANCE_SIGNATURE");
+  }
+
+  std::atomic<int> queries = 0;
+
+ private:
+  std::string reply_;
+  std::chrono::milliseconds delay_;
+  int fd_;
+  std::thread thread_;
+};
+
+// Listening socket2 in a temporary instance folder, for an IPC created with modulesReady set
+class Socket2Server {
+ public:
+  Socket2Server(const fs::path& runtimeDir, const char* instanceSig) : runtimeDir_(runtimeDir) {
+    IPCTestFixture::resetSocketFolder();
+    fs::create_directories(runtimeDir / "hypr" / instanceSig);
+    setenv("XDG_RUNTIME_DIR", runtimeDir.c_str(), 1);
+    setenv("HYPRLAND_INSTANCE_SIGNATURE", instanceSig, 1);
+    auto path = runtimeDir / "hypr" / instanceSig / ".socket2.sock";
+    fs::remove(path);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    listen(fd_, 1);
+    hyprland::modulesReady = true;
+  }
+
+  ~Socket2Server() {
+    hyprland::modulesReady = false;
+    close(fd_);
+    unsetenv("HYPRLAND_INSTANCE_SIGNATURE");
+    fs::remove_all(runtimeDir_);
+  }
+
+  // The connection of the IPC listener
+  int accept() { return ::accept(fd_, nullptr, nullptr); }
+
+ private:
+  fs::path runtimeDir_;
+  int fd_;
+};
@@ -0,0 +1,138 @@
+#include "modules/hyprland/state.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+#include "util/json.hpp"
+
+using waybar::modules::hyprland::State;
+
+namespace {
+// Two monitors, workspace 1 on DP-1 with a focused kitty, workspace 2 on HDMI-A-1 with firefox
+State makeState() {
+  waybar::util::JsonParser parser;
+  auto monitors = parser.parse(R"([
+    {"id": 0, "name": "DP-1", "focused": true, "activeWorkspace": {"id": 1, "name": "1"},
+     "specialWorkspace": {"id": 0, "name": ""}},
+    {"id": 1, "name": "HDMI-A-1", "focused": false, "activeWorkspace": {"id": 2, "name": "2"},
+     "specialWorkspace": {"id": 0, "name": ""}}
+  ])");
+  auto workspaces = parser.parse(R"([
+    {"id": 1, "name": "1", "monitor": "DP-1", "windows": 1, "hasfullscreen": false},
+    {"id": 2, "name": "2", "monitor": "HDMI-A-1", "windows": 1, "hasfullscreen": false},
+    {"id": -98, "name": "special:scratch", "monitor": "DP-1", "windows": 0,
+     "hasfullscreen": false}
+  ])");
+  auto clients = parser.parse(R"([
+    {"address": "0xa1", "workspace": {"id": 1, "name": "1"}, "class": "kitty",
+     "initialClass": "kitty", "title": "~", "initialTitle": "kitty", "floating": false,
+     "fullscreen": 0, "mapped": true, "hidden": false, "focusHistoryID": 0},
+    {"address": "0xb2", "workspace": {"id": 2, "name": "2"}, "class": "firefox",
+     "initialClass": "firefox", "title": "Mozilla Firefox", "initialTitle": "Mozilla Firefox",
+     "floating": false, "fullscreen": 0, "mapped": true, "hidden": false, "focusHistoryID": 1}
+  ])");
+  return State::fromJson(monitors, workspaces, clients);
+}
+}  // namespace
+
+TEST_CASE("State is read from the socket1 replies", "[state]") {
+  auto state = makeState();
+
+  REQUIRE(state.monitors.size() == 2);
+  REQUIRE(state.focusedMonitor()->name == "DP-1");
+  REQUIRE(state.findMonitor("HDMI-A-1")->activeWorkspaceId == 2);
+  REQUIRE(state.findWorkspace("special:scratch")->id == -98);
+  REQUIRE(state.findClient("a1")->className == "kitty");
+  REQUIRE(state.findClient("0xa1") == nullptr);
+  REQUIRE(state.activeWindow == "a1");
+
+  auto clients = state.clientsJson(2);
+  REQUIRE(clients.size() == 1);
+  REQUIRE(clients[0]["address"].asString() == "0xb2");
+  REQUIRE(clients[0]["workspace"]["name"].asString() == "2");
+}
+
+TEST_CASE("State follows window events", "[state]") {
+  auto state = makeState();
+
+  REQUIRE(state.apply("openwindow>>c3,1,foot,vim a, b"));
+  REQUIRE(state.findClient("c3")->title == "vim a, b");
+  REQUIRE(state.findWorkspace(1)->windows == 2);
+
+  REQUIRE(state.apply("windowtitlev2>>c3,vim, c"));
+  REQUIRE(state.findClient("c3")->title == "vim, c");
+
+  REQUIRE(state.apply("movewindow>>c3,2"));
+  REQUIRE(state.apply("movewindowv2>>c3,2,2"));
+  REQUIRE(state.findWorkspace(1)->windows == 1);
+  REQUIRE(state.findWorkspace(2)->windows == 2);
+
+  REQUIRE(state.apply("activewindowv2>>c3"));
+  REQUIRE(state.apply("fullscreen>>1"));
+  REQUIRE(state.findWorkspace(2)->hasFullscreen);
+  REQUIRE(state.apply("changefloatingmode>>c3,1"));
+  REQUIRE(state.findClient("c3")->floating);
+
+  REQUIRE(state.apply("closewindow>>c3"));
+  REQUIRE(state.findClient("c3") == nullptr);
+  REQUIRE(state.findWorkspace(2)->windows == 1);
+  REQUIRE_FALSE(state.findWorkspace(2)->hasFullscreen);
+  REQUIRE(state.activeWindow.empty());
+  // Closed twice, e.g. when the state was read after the window closed
+  REQUIRE(state.apply("closewindow>>c3"));
+}
+
+TEST_CASE("State follows workspace and monitor events", "[state]") {
+  auto state = makeState();
+
+  REQUIRE(state.apply("workspace>>2"));
+  REQUIRE(state.apply("workspacev2>>2,2"));
+  REQUIRE(state.focusedMonitor()->name == "HDMI-A-1");
+
+  // As read again after createworkspacev2
+  state.workspaces[3] = {.id = 3, .name = "3", .monitor = "HDMI-A-1"};
+  REQUIRE(state.apply("moveworkspacev2>>3,3,DP-1"));
+  REQUIRE(state.findWorkspace(3)->monitor == "DP-1");
+  REQUIRE(state.apply("renameworkspace>>3,code"));
+  REQUIRE(state.findWorkspace("code")->id == 3);
+
+  REQUIRE(state.apply("focusedmonv2>>DP-1,3"));
+  REQUIRE(state.focusedMonitor()->activeWorkspaceId == 3);
+  REQUIRE(state.findMonitor("HDMI-A-1")->activeWorkspaceId == 2);
+
+  REQUIRE(state.apply("activespecialv2>>-98,special:scratch,DP-1"));
+  REQUIRE(state.findMonitor("DP-1")->specialWorkspaceId == -98);
+  REQUIRE(state.apply("activespecialv2>>,,DP-1"));
+  REQUIRE(state.findMonitor("DP-1")->specialWorkspaceName.empty());
+
+  REQUIRE(state.apply("destroyworkspacev2>>3,code"));
+  REQUIRE(state.findWorkspace(3) == nullptr);
+
+  REQUIRE(state.apply("submap>>resize"));
+}
+
+TEST_CASE("State reads created workspaces again", "[state]") {
+  auto state = makeState();
+
+  // A rule binds workspace 3 to HDMI-A-1 while DP-1 is focused, no moveworkspace follows
+  REQUIRE_FALSE(state.apply("createworkspacev2>>3,3"));
+  state.workspaces[3] = {.id = 3, .name = "3", .monitor = "HDMI-A-1"};
+  REQUIRE(state.apply("workspacev2>>3,3"));
+  REQUIRE(state.apply("focusedmonv2>>HDMI-A-1,3"));
+  REQUIRE(state.focusedMonitor()->name == "HDMI-A-1");
+  REQUIRE(state.findMonitor("HDMI-A-1")->activeWorkspaceId == 3);
+  REQUIRE(state.findMonitor("DP-1")->activeWorkspaceId == 1);
+}
+
+TEST_CASE("State reports drift", "[state]") {
+  auto state = makeState();
+
+  REQUIRE_FALSE(state.apply("windowtitlev2>>ffff,unknown"));
+  REQUIRE_FALSE(state.apply("openwindow>>d4,9,foot,foot"));
+  REQUIRE_FALSE(state.apply("workspacev2>>9,9"));
+  REQUIRE_FALSE(state.apply("monitoraddedv2>>2,DP-2,Dell"));
+  REQUIRE_FALSE(state.apply("configreloaded>>"));
+}
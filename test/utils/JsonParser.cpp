@@ -5,6 +5,14 @@
 #else
 #include <catch2/catch.hpp>
 #endif
+#if __has_include(<catch2/benchmark/catch_benchmark.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define WAYBAR_HAVE_CATCH_BENCHMARK
+#endif
+#include <fmt/format.h>
+
+#include <regex>
+#include <sstream>
 
 TEST_CASE("Simple json", "[json]") {
   SECTION("Parse simple json") {
@@ -42,4 +50,75 @@ TEST_CASE("Json with chinese characters", "[json]") {
     Json::Value jsonValue = parser.parse(stringToTest);
     REQUIRE(jsonValue["test"].asString() == "你好");
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Json with hexadecimal escapes", "[json]") {
+  waybar::util::JsonParser parser;
+
+  SECTION("Rewrite every escape") {
+    auto jsonValue = parser.parse(R"({"a": "\x41\x42", "\x43": "c"})");
+    REQUIRE(jsonValue["a"].asString() == "AB");
+    REQUIRE(jsonValue["C"].asString() == "c");
+  }
+
+  SECTION("Keep escaped backslashes") {
+    auto jsonValue = parser.parse(R"({"path": "C:\\xyz", "mixed": "\\\x41"})");
+    REQUIRE(jsonValue["path"].asString() == "C:\\xyz");
+    REQUIRE(jsonValue["mixed"].asString() == "\\A");
+  }
+
+  SECTION("Reuse the parser after an error") {
+    REQUIRE_THROWS_AS(parser.parse(R"({"a": "\)"), std::runtime_error);
+    REQUIRE_THROWS_AS(parser.parse(""), std::runtime_error);
+    REQUIRE(parser.parse(R"([1, 2])").size() == 2);
+  }
+}
+
+#ifdef WAYBAR_HAVE_CATCH_BENCHMARK
+namespace {
+// Shaped like the reply to `hyprctl -j clients`, about 1 KiB per client
+std::string makeClients(int count, bool hexadecimal_escape) {
+  std::string json = "[";
+  for (int i = 0; i < count; i++) {
+    json += fmt::format(
+        R"({}{{"address": "0x{:x}", "mapped": true, "hidden": false, "at": [{}, {}],)"
+        R"( "size": [1280, 1400], "workspace": {{"id": {}, "name": "{}"}}, "floating": false,)"
+        R"( "pseudo": false, "monitor": 0, "class": "org.example.App{}",)"
+        R"( "title": "Document {} - Editor{}", "initialClass": "org.example.App{}",)"
+        R"( "initialTitle": "Editor", "pid": {}, "xwayland": false, "pinned": false,)"
+        R"( "fullscreen": 0, "fullscreenClient": 0, "grouped": [], "tags": [],)"
+        R"( "swallowing": "0x0", "focusHistoryID": {}, "inhibitingIdle": false}})",
+        i == 0 ? "" : ",", 0x55d0c0de0000 + i * 0x100, i * 10, i * 20, i % 10 + 1, i % 10 + 1, i,
+        i, hexadecimal_escape && i % 50 == 0 ? " \\xe2" : "", i, 1000 + i, i);
+  }
+  json += "]";
+  return json;
+}
+
+// The parser as it was: regex rewrite, then a copy into a stream
+Json::Value parseWithRegex(const std::string& json) {
+  static std::regex re("\\\\x");
+  std::istringstream stream(std::regex_replace(json, re, "\\u00"));
+  Json::CharReaderBuilder builder;
+  Json::Value root;
+  std::string errs;
+  Json::parseFromStream(builder, stream, &root, &errs);
+  return root;
+}
+}  // namespace
+
+TEST_CASE("Benchmark json parsing", "[!benchmark][json]") {
+  waybar::util::JsonParser parser;
+  auto clients = makeClients(500, false);
+  auto escaped = makeClients(500, true);
+  REQUIRE(parser.parse(clients) == parseWithRegex(clients));
+  REQUIRE(parser.parse(escaped) == parseWithRegex(escaped));
+
+  BENCHMARK("500 clients") { return parser.parse(clients).size(); };
+  BENCHMARK("500 clients, regex and stream") { return parseWithRegex(clients).size(); };
+  BENCHMARK("500 clients with \\x escapes") { return parser.parse(escaped).size(); };
+  BENCHMARK("500 clients with \\x escapes, regex and stream") {
+    return parseWithRegex(escaped).size();
+  };
+}
+#endif
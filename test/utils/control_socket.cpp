@@ -0,0 +1,80 @@
+#include "util/control_socket.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+using namespace std::chrono_literals;
+using waybar::util::ControlSocket;
+
+TEST_CASE("Control socket requests are split into words", "[control_socket][util]") {
+  auto request = ControlSocket::parse("push custom/vpn {\"text\": \"up\", \"class\": \"on\"}");
+  REQUIRE(request);
+  REQUIRE(request->command == "push");
+  REQUIRE(request->module == "custom/vpn");
+  REQUIRE(request->output.empty());
+  REQUIRE(request->argument == "{\"text\": \"up\", \"class\": \"on\"}");
+
+  request = ControlSocket::parse("action custom/vpn#work@DP-1 on-click\r");
+  REQUIRE(request);
+  REQUIRE(request->module == "custom/vpn#work");
+  REQUIRE(request->output == "DP-1");
+  REQUIRE(request->argument == "on-click");
+
+  request = ControlSocket::parse("  list");
+  REQUIRE(request);
+  REQUIRE(request->command == "list");
+  REQUIRE(request->module.empty());
+  REQUIRE(request->argument.empty());
+
+  REQUIRE_FALSE(ControlSocket::parse(""));
+  REQUIRE_FALSE(ControlSocket::parse("   "));
+}
+
+TEST_CASE("Control socket queues replies the client doesn't read right away",
+          "[control_socket][util]") {
+  auto path = std::filesystem::temp_directory_path() /
+              ("waybar-control-socket-" + std::to_string(getpid()) + ".sock");
+  // Far more than the socket buffer holds
+  const std::string reply(1 << 20, 'x');
+  ControlSocket control(path, [&reply](const auto& /*request*/) { return reply; }, [] {});
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  REQUIRE(connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0);
+  // Write a batch and stop writing before reading anything, as `socat` does
+  std::string requests = "get a\nget b\n";
+  REQUIRE(write(fd, requests.data(), requests.size()) == static_cast<ssize_t>(requests.size()));
+  shutdown(fd, SHUT_WR);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+
+  auto context = Glib::MainContext::get_default();
+  std::string received;
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  bool closed = false;
+  while (!closed && std::chrono::steady_clock::now() < deadline) {
+    context->iteration(false);
+    std::array<char, 65536> chunk;
+    auto n = read(fd, chunk.data(), chunk.size());
+    if (n > 0) {
+      received.append(chunk.data(), n);
+    }
+    closed = n == 0;
+  }
+  close(fd);
+  REQUIRE(closed);
+  REQUIRE(received == reply + "\n" + reply + "\n");
+}
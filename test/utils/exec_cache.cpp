@@ -0,0 +1,99 @@
+#include "util/exec_cache.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using waybar::util::ExecCache;
+
+namespace {
+// Command appending a line to a file at each run, then printing how many runs there were
+std::string countingCommand(const std::filesystem::path& runs, const std::string& delay = "0") {
+  return "echo >> " + runs.string() + "; sleep " + delay + "; wc -l < " + runs.string();
+}
+
+size_t count(const std::filesystem::path& runs) {
+  std::ifstream file(runs);
+  return std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
+}
+}  // namespace
+
+TEST_CASE("Exec cache reuses recent results", "[exec_cache][util]") {
+  auto runs = std::filesystem::temp_directory_path() /
+              ("waybar-exec-cache-" + std::to_string(getpid()) + "-ttl");
+  auto cmd = countingCommand(runs);
+  auto stats = waybar::util::Telemetry::inst().create("custom/test", "");
+  waybar::util::Telemetry::Scope scope(stats);
+
+  auto first = ExecCache::inst().exec(cmd, "", 1h);
+  REQUIRE(first.exit_code == 0);
+  REQUIRE(ExecCache::inst().exec(cmd, "", 1h).out == first.out);
+  REQUIRE(stats->exec_hits == 1);
+  // Another output is another command, and a zero TTL never hits
+  ExecCache::inst().exec(cmd, "DP-1", 1h);
+  ExecCache::inst().exec(cmd, "", 0ms);
+  REQUIRE(count(runs) == 3);
+  REQUIRE(stats->exec_hits == 1);
+  std::filesystem::remove(runs);
+}
+
+TEST_CASE("Exec cache joins running commands", "[exec_cache][util]") {
+  auto runs = std::filesystem::temp_directory_path() /
+              ("waybar-exec-cache-" + std::to_string(getpid()) + "-join");
+  auto cmd = countingCommand(runs, "0.3");
+  auto stats = waybar::util::Telemetry::inst().create("custom/test", "");
+
+  std::vector<std::thread> threads;
+  std::vector<std::string> outputs(4);
+  for (size_t i = 0; i < outputs.size(); i++) {
+    threads.emplace_back([&, i] {
+      waybar::util::Telemetry::Scope scope(stats);
+      outputs[i] = ExecCache::inst().exec(cmd, "", 0ms).out;
+    });
+    // Let the first one start the command
+    std::this_thread::sleep_for(i == 0 ? 100ms : 0ms);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(count(runs) == 1);
+  REQUIRE(stats->exec_joined == outputs.size() - 1);
+  REQUIRE(std::all_of(outputs.begin(), outputs.end(), [](const auto& out) { return out == "1"; }));
+  std::filesystem::remove(runs);
+}
+
+TEST_CASE("Exec cache recovers from a cancelled run", "[exec_cache][util]") {
+  auto runs = std::filesystem::temp_directory_path() /
+              ("waybar-exec-cache-" + std::to_string(getpid()) + "-cancel");
+  auto cmd = countingCommand(runs, "0.3");
+  auto stats = waybar::util::Telemetry::inst().create("custom/test", "");
+  waybar::util::Telemetry::Scope scope(stats);
+
+  // As SleeperThread::stop() does to a worker waiting for its command
+  std::thread cancelled([&cmd] { ExecCache::inst().exec(cmd, "", 0ms); });
+  std::thread canceller([&cancelled] {
+    std::this_thread::sleep_for(150ms);
+    pthread_cancel(cancelled.native_handle());
+  });
+  // Waits for the cancelled run, then runs the command itself
+  std::this_thread::sleep_for(50ms);
+  auto result = ExecCache::inst().exec(cmd, "", 0ms);
+  canceller.join();
+  cancelled.join();
+
+  REQUIRE(result.out == "2");
+  REQUIRE(stats->exec_misses == 1);
+  REQUIRE(stats->exec_joined == 0);
+  std::filesystem::remove(runs);
+}
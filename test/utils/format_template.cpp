@@ -0,0 +1,75 @@
+#include "util/format_template.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <charconv>
+
+using waybar::util::FormatTemplate;
+
+namespace {
+enum Slot { USAGE, CORE };
+
+int bind(std::string_view name, size_t& index) {
+  if (name == "usage") return USAGE;
+  if (name.starts_with("usage")) {
+    std::from_chars(name.data() + 5, name.data() + name.size(), index);
+    return CORE;
+  }
+  return -1;
+}
+
+std::string render(const FormatTemplate& tmpl, int usage, const std::vector<int>& cores) {
+  std::string out;
+  tmpl.render(out, [&](const FormatTemplate::Field& field, std::string& out) {
+    switch (field.slot) {
+      case USAGE:
+        field.append(out, usage);
+        break;
+      case CORE:
+        field.append(out, cores.at(field.index));
+        break;
+      default:
+        FormatTemplate::unknownField(field);
+    }
+  });
+  return out;
+}
+}  // namespace
+
+TEST_CASE("Format templates render like fmt", "[format_template][util]") {
+  std::vector<int> cores = {3, 14, 15};
+
+  SECTION("Named fields and specs") {
+    FormatTemplate tmpl("CPU {usage:>3}% [{usage0} {usage2:02}]", bind);
+    REQUIRE(render(tmpl, 42, cores) == fmt::format("CPU {:>3}% [{} {:02}]", 42, 3, 15));
+  }
+
+  SECTION("Escaped braces and plain text") {
+    FormatTemplate tmpl("{{{usage}}} <b>text</b>", bind);
+    REQUIRE(render(tmpl, 7, cores) == "{7} <b>text</b>");
+    REQUIRE(render(FormatTemplate("no fields"), 0, cores) == "no fields");
+  }
+
+  SECTION("Positional fields are named after their index") {
+    FormatTemplate tmpl("{}% {usage}");
+    REQUIRE(tmpl.uses("0"));
+    REQUIRE(tmpl.uses("usage"));
+    REQUIRE_FALSE(tmpl.uses("usage1"));
+  }
+
+  SECTION("Only referenced slots are bound") {
+    FormatTemplate tmpl("{usage1}", bind);
+    REQUIRE(tmpl.usesSlot(CORE));
+    REQUIRE_FALSE(tmpl.usesSlot(USAGE));
+    REQUIRE(tmpl.fields().front().index == 1);
+  }
+
+  SECTION("Errors") {
+    REQUIRE_THROWS_AS(FormatTemplate("{usage"), fmt::format_error);
+    REQUIRE_THROWS_AS(FormatTemplate("usage}"), fmt::format_error);
+    REQUIRE_THROWS_AS(render(FormatTemplate("{unknown}", bind), 0, cores), fmt::format_error);
+  }
+}
@@ -0,0 +1,127 @@
+#include "util/proc_stat.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#if __has_include(<catch2/benchmark/catch_benchmark.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#define WAYBAR_HAVE_CATCH_BENCHMARK
+#endif
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using waybar::util::CpuTimes;
+using waybar::util::ProcStat;
+
+namespace {
+// /proc/stat as seen on a machine with `ncpu` cpus, each one with distinct counters
+std::string makeProcStat(size_t ncpu) {
+  std::string stat = "cpu  10132153 290696 3084719 46828483 16683 0 25195 0 175628 0\n";
+  for (size_t i = 0; i < ncpu; i++) {
+    stat += fmt::format("cpu{} {} {} {} {} {} 0 {} 0 0 0\n", i, 10000 + i, 100 + i, 5000 + i,
+                        200000 + i, 30 + i, 7 + i);
+  }
+  stat +=
+      "intr 1462898 0 0 0 0 0 0 0 0 1 0 0 0 0 0 0 0\n"
+      "ctxt 2431637\n"
+      "btime 1713012345\n"
+      "processes 12345\n"
+      "procs_running 2\n"
+      "procs_blocked 0\n";
+  return stat;
+}
+}  // namespace
+
+TEST_CASE("Parse /proc/stat cpu lines", "[proc_stat][util]") {
+  CpuTimes times;
+
+  SECTION("Sum and per-core counters") {
+    ProcStat::parse(
+        "cpu  10 20 30 40 50 60 70 80 0 0\n"
+        "cpu0 1 2 3 4 5 6 7 8 0 0\n"
+        "cpu1 9 8 7 6 5 4 3 2 0 0\n"
+        "intr 1 2 3\n",
+        0, times);
+    REQUIRE(times.size() == 3);
+    REQUIRE(times.idle[0] == 90);
+    REQUIRE(times.total[0] == 360);
+    REQUIRE(times.idle[1] == 9);
+    REQUIRE(times.total[1] == 36);
+    REQUIRE(times.idle[2] == 11);
+    REQUIRE(times.total[2] == 44);
+  }
+
+  SECTION("Offline cpus are zero-filled") {
+    ProcStat::parse(
+        "cpu  10 20 30 40 50 0 0 0 0 0\n"
+        "cpu0 1 2 3 4 5 0 0 0 0 0\n"
+        "cpu2 1 2 3 4 5 0 0 0 0 0\n",
+        3, times);
+    REQUIRE(times.size() == 5);
+    REQUIRE(times.total[1] == 15);
+    REQUIRE(times.total[2] == 0);
+    REQUIRE(times.total[3] == 15);
+    REQUIRE(times.total[4] == 0);
+  }
+
+  SECTION("Cpu numbers with three digits") {
+    ProcStat::parse(makeProcStat(256), 255, times);
+    REQUIRE(times.size() == 257);
+    REQUIRE(times.idle[129] == 200000 + 128 + 30 + 128);
+    REQUIRE(times.total[256] == 10000 + 100 + 5000 + 200000 + 30 + 7 + 255 * 6);
+  }
+
+  SECTION("Counters are accumulated on 64 bits") {
+    ProcStat::parse(
+        "cpu  4000000000 4000000000 4000000000 4000000000 4000000000 0 0 0 0 0\n"
+        "cpu0 4000000000 4000000000 4000000000 4000000000 4000000000 0 0 0 0 0\n",
+        0, times);
+    REQUIRE(times.idle[0] == 8000000000ULL);
+    REQUIRE(times.total[0] == 20000000000ULL);
+  }
+}
+
+TEST_CASE("Parsing /proc/stat reuses storage", "[proc_stat][util]") {
+  auto fixture = makeProcStat(256);
+  CpuTimes times;
+  ProcStat::parse(fixture, 255, times);
+  const auto* idle = times.idle.data();
+  const auto* total = times.total.data();
+
+  ProcStat::parse(fixture, 255, times);
+  REQUIRE(times.idle.data() == idle);
+  REQUIRE(times.total.data() == total);
+}
+
+TEST_CASE("Read /proc/stat from a file", "[proc_stat][util]") {
+  auto path = std::filesystem::temp_directory_path() / "waybar-test-proc-stat";
+  auto fixture = makeProcStat(256);
+  {
+    std::ofstream file(path);
+    file << fixture;
+  }
+  ProcStat proc_stat(path, "/nonexistent");
+  CpuTimes times;
+  proc_stat.read(times);
+  REQUIRE(times.size() == 257);
+  REQUIRE(times.total[1] == 10000 + 100 + 5000 + 200000 + 30 + 7);
+
+  std::filesystem::remove(path);
+}
+
+#ifdef WAYBAR_HAVE_CATCH_BENCHMARK
+TEST_CASE("Benchmark /proc/stat parsing", "[!benchmark][proc_stat][util]") {
+  auto fixture = makeProcStat(256);
+  CpuTimes times;
+
+  BENCHMARK("parse 256 cpus") {
+    ProcStat::parse(fixture, 255, times);
+    return times.size();
+  };
+}
+#endif
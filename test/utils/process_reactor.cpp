@@ -0,0 +1,142 @@
+#include "util/process_reactor.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono_literals;
+using waybar::util::ProcessReactor;
+
+namespace {
+// Lines and exit codes of a watched command, as seen from another thread
+struct Recorder {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> lines;
+  std::vector<int> exits;
+
+  ProcessReactor::Handler handler() {
+    return {[this](std::string line) {
+              std::lock_guard lock(mutex);
+              lines.push_back(std::move(line));
+              cv.notify_all();
+            },
+            [this](int exit_code) {
+              std::lock_guard lock(mutex);
+              exits.push_back(exit_code);
+              cv.notify_all();
+            }};
+  }
+
+  bool waitLines(size_t count) {
+    std::unique_lock lock(mutex);
+    return cv.wait_for(lock, 5s, [this, count] { return lines.size() >= count; });
+  }
+
+  bool waitExits(size_t count) {
+    std::unique_lock lock(mutex);
+    return cv.wait_for(lock, 5s, [this, count] { return exits.size() >= count; });
+  }
+};
+}  // namespace
+
+TEST_CASE("Reactor hands out lines and exit codes", "[process_reactor][util]") {
+  Recorder recorder;
+  auto watch = ProcessReactor::inst().watch({"printf 'one\\ntwo\\nthree'; exit 3"},
+                                            recorder.handler());
+  REQUIRE(recorder.waitExits(1));
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.lines == std::vector<std::string>{"one", "two", "three"});
+  REQUIRE(recorder.exits == std::vector<int>{3});
+}
+
+TEST_CASE("Reactor survives handlers that throw", "[process_reactor][util]") {
+  Recorder recorder;
+  auto handler = recorder.handler();
+  auto line = handler.line;
+  handler.line = [line](std::string text) {
+    if (text == "bad") {
+      throw std::runtime_error("malformed");
+    }
+    line(std::move(text));
+  };
+  auto watch = ProcessReactor::inst().watch({"printf 'one\\nbad\\ntwo'; exit 1"}, handler);
+  REQUIRE(recorder.waitExits(1));
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.lines == std::vector<std::string>{"one", "two"});
+}
+
+TEST_CASE("Reactor restarts commands after their restart interval", "[process_reactor][util]") {
+  Recorder recorder;
+  ProcessReactor::Command command{"echo $WAYBAR_OUTPUT_NAME", "DP-1", 50ms};
+  auto start = std::chrono::steady_clock::now();
+  auto watch = ProcessReactor::inst().watch(command, recorder.handler());
+  REQUIRE(recorder.waitExits(3));
+  REQUIRE(std::chrono::steady_clock::now() - start >= 100ms);
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.lines.front() == "DP-1");
+}
+
+TEST_CASE("Reactor kills commands that are no longer watched", "[process_reactor][util]") {
+  Recorder recorder;
+  auto size = ProcessReactor::inst().size();
+  auto watch = ProcessReactor::inst().watch({"echo started; exec sleep 60"}, recorder.handler());
+  REQUIRE(ProcessReactor::inst().size() == size + 1);
+  watch.reset();
+  REQUIRE(ProcessReactor::inst().size() == size);
+  std::this_thread::sleep_for(100ms);
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.exits.empty());
+}
+
+TEST_CASE("Reactor re-reads watched files when they change", "[process_reactor][util]") {
+  auto dir = std::filesystem::temp_directory_path() / ("waybar-test-" + std::to_string(getpid()));
+  std::filesystem::create_directories(dir);
+  auto path = dir / "status";
+  std::ofstream(path) << "one\n";
+  Recorder recorder;
+  auto watch = ProcessReactor::inst().watchFile(path, recorder.handler().line);
+  REQUIRE(recorder.waitLines(1));
+
+  std::ofstream(path) << "two\ntooltip\n";
+  REQUIRE(recorder.waitLines(2));
+  // Replaced atomically, as most daemons do
+  std::ofstream(dir / "status.tmp") << "three";
+  std::filesystem::rename(dir / "status.tmp", path);
+  REQUIRE(recorder.waitLines(3));
+  std::filesystem::remove(path);
+  REQUIRE(recorder.waitLines(4));
+  watch.reset();
+  std::filesystem::remove_all(dir);
+
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.lines == std::vector<std::string>{"one", "two\ntooltip", "three", ""});
+}
+
+TEST_CASE("Reactor reads named pipes line by line", "[process_reactor][util]") {
+  auto path = std::filesystem::temp_directory_path() /
+              ("waybar-test-" + std::to_string(getpid()) + ".fifo");
+  REQUIRE(mkfifo(path.c_str(), 0600) == 0);
+  Recorder recorder;
+  auto watch = ProcessReactor::inst().watchFile(path, recorder.handler().line);
+  // Each writer closing the pipe must not end the stream
+  std::ofstream(path) << "one\ntw";
+  std::ofstream(path) << "o\n";
+  std::ofstream(path) << "three\n";
+  REQUIRE(recorder.waitLines(3));
+  watch.reset();
+  std::filesystem::remove(path);
+
+  std::lock_guard lock(recorder.mutex);
+  REQUIRE(recorder.lines == std::vector<std::string>{"one", "two", "three"});
+}
@@ -0,0 +1,79 @@
+#include "util/provider.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+using waybar::util::Dispatcher;
+using waybar::util::SampledProvider;
+using waybar::util::Scheduler;
+
+TEST_CASE("Providers are shared by type and configuration", "[provider][util]") {
+  auto sampler = [] { return 1; };
+  auto a = SampledProvider<int>::get("test-shared", 1000ms, sampler);
+  auto b = SampledProvider<int>::get("test-shared", 1000ms, sampler);
+  auto c = SampledProvider<int>::get("test-shared", 2000ms, sampler);
+  auto d = SampledProvider<int>::get("test-other", 1000ms, sampler);
+
+  REQUIRE(a == b);
+  REQUIRE(a != c);
+  REQUIRE(a != d);
+}
+
+TEST_CASE("A blocked sampler holds up neither the scheduler nor the modules",
+          "[provider][util]") {
+  // Every interval module and clock is woken by the shared scheduler, and a sampled module's
+  // dispatch and update() only touch the provider's snapshot and subscribers: neither may wait
+  // for a sampler stuck on a slow kernel interface.
+  constexpr auto update_budget = 5ms;
+  std::atomic<int> calls = 0;
+  auto provider = SampledProvider<int>::get("test-slow", 50ms, [&calls] {
+    if (calls++ > 0) {
+      std::this_thread::sleep_for(500ms);
+    }
+    return calls.load();
+  });
+  Dispatcher dp;
+  provider->attach(dp);
+  std::atomic<int> ticks = 0;
+  auto clock = Scheduler::inst().schedule(10ms, [&ticks] { ticks++; });
+
+  // The first sample is published, then dispatched to the module
+  bool dispatched = false;
+  auto deadline = std::chrono::steady_clock::now() + 1s;
+  while (!dispatched && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(5ms);
+    dispatched = dp.takeLatency() != std::chrono::steady_clock::duration::zero();
+  }
+  REQUIRE(dispatched);
+
+  // Let the next, slow, sample start
+  std::this_thread::sleep_for(100ms);
+  REQUIRE(calls >= 2);
+
+  // Ticks of the other subscription while the sampler blocks
+  auto ticked = ticks.load();
+  std::this_thread::sleep_for(200ms);
+  REQUIRE(ticks - ticked >= 10);
+
+  // What the modules do on the main loop meanwhile: another bar's copy attaching, then update()
+  // taking its dispatch latency and reading the snapshot
+  auto start = std::chrono::steady_clock::now();
+  Dispatcher other;
+  provider->attach(other);
+  dp.takeLatency();
+  auto snapshot = provider->snapshot();
+  provider->detach(other);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  REQUIRE(snapshot);
+  REQUIRE(*snapshot == 1);
+  REQUIRE(elapsed < update_budget);
+  provider->detach(dp);
+}
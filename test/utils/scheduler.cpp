@@ -0,0 +1,114 @@
+#include "util/scheduler.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using waybar::util::Scheduler;
+
+TEST_CASE("Scheduler fires immediately and then on interval", "[scheduler][util]") {
+  Scheduler scheduler;
+  std::atomic<int> count = 0;
+  auto sub = scheduler.schedule(50ms, [&count] { count++; });
+
+  std::this_thread::sleep_for(20ms);
+  REQUIRE(count >= 1);
+  std::this_thread::sleep_for(200ms);
+  REQUIRE(count >= 3);
+}
+
+TEST_CASE("Scheduler fires 'once' interval a single time, then on trigger", "[scheduler][util]") {
+  Scheduler scheduler;
+  std::atomic<int> count = 0;
+  auto sub = scheduler.schedule(std::chrono::milliseconds::max(), [&count] { count++; });
+
+  std::this_thread::sleep_for(50ms);
+  REQUIRE(count == 1);
+  std::this_thread::sleep_for(50ms);
+  REQUIRE(count == 1);
+  sub.trigger();
+  std::this_thread::sleep_for(50ms);
+  REQUIRE(count == 2);
+  REQUIRE(scheduler.stats().subscriptions == 1);
+}
+
+TEST_CASE("Scheduler coalesces equal intervals into one wakeup", "[scheduler][util]") {
+  Scheduler scheduler;
+  std::atomic<int> count = 0;
+  std::vector<Scheduler::Subscription> subs;
+  for (int i = 0; i < 10; i++) {
+    subs.push_back(scheduler.schedule(100ms, [&count] { count++; }));
+  }
+  // Skip the initial immediate ticks, which are subject to registration timing
+  std::this_thread::sleep_for(50ms);
+  auto before = scheduler.stats();
+  std::this_thread::sleep_for(300ms);
+  auto after = scheduler.stats();
+
+  REQUIRE(after.subscriptions == 10);
+  auto wakeups = after.wakeups - before.wakeups;
+  auto callbacks = after.callbacks - before.callbacks;
+  REQUIRE(wakeups >= 2);
+  REQUIRE(wakeups <= 4);
+  REQUIRE(callbacks == wakeups * 10);
+}
+
+TEST_CASE("Scheduler slack merges nearby deadlines", "[scheduler][util]") {
+  Scheduler scheduler;
+  scheduler.setSlack(60ms);
+  std::atomic<int> count = 0;
+  auto a = scheduler.schedule(70ms, [&count] { count++; });
+  auto b = scheduler.schedule(110ms, [&count] { count++; });
+  std::this_thread::sleep_for(20ms);
+  auto before = scheduler.stats();
+  std::this_thread::sleep_for(400ms);
+  auto after = scheduler.stats();
+
+  // Without slack the two timers rarely share a boundary and need ~9 wakeups
+  REQUIRE(after.wakeups - before.wakeups <= 7);
+  REQUIRE(after.callbacks - before.callbacks >= 8);
+}
+
+TEST_CASE("Scheduler slack never fires a subscription early", "[scheduler][util]") {
+  Scheduler scheduler;
+  scheduler.setSlack(30ms);
+  std::mutex mutex;
+  std::vector<Scheduler::clock::duration> offsets;
+  auto a = scheduler.schedule(
+      100ms,
+      [&] {
+        std::lock_guard lock(mutex);
+        offsets.push_back(Scheduler::clock::now().time_since_epoch() % 100ms);
+      },
+      false);
+  auto b = scheduler.schedule(70ms, [] {});
+  std::this_thread::sleep_for(1s);
+  a.reset();
+
+  // Fired early, "a" would land up to 30ms before its boundary and render the previous interval
+  std::lock_guard lock(mutex);
+  REQUIRE(offsets.size() >= 8);
+  for (auto offset : offsets) {
+    REQUIRE(offset < 50ms);
+  }
+}
+
+TEST_CASE("Scheduler stops calling cancelled subscriptions", "[scheduler][util]") {
+  Scheduler scheduler;
+  std::atomic<int> count = 0;
+  auto sub = scheduler.schedule(20ms, [&count] { count++; });
+  std::this_thread::sleep_for(50ms);
+  sub.reset();
+  auto fired = count.load();
+  std::this_thread::sleep_for(100ms);
+  REQUIRE(count == fired);
+  REQUIRE(scheduler.stats().subscriptions == 0);
+}
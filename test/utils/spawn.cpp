@@ -0,0 +1,154 @@
+#include "util/spawn.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+using waybar::util::spawn;
+using waybar::util::SpawnOptions;
+using waybar::util::splitSimpleCommand;
+
+namespace {
+// Run `cmd` and return what it printed and its exit status
+std::pair<std::string, int> run(const std::string& cmd, SpawnOptions options = {}) {
+  int fd[2];
+  REQUIRE(pipe2(fd, O_CLOEXEC) == 0);
+  options.stdout_fd = fd[1];
+  pid_t pid = spawn(cmd, options);
+  close(fd[1]);
+  REQUIRE(pid > 0);
+  std::string output;
+  char buffer[256];
+  ssize_t n;
+  while ((n = read(fd[0], buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, n);
+  }
+  close(fd[0]);
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  return {output, WEXITSTATUS(status)};
+}
+
+size_t rssKiB() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.starts_with("VmRSS:")) {
+      return std::stoul(line.substr(6));
+    }
+  }
+  return 0;
+}
+}  // namespace
+
+TEST_CASE("Simple commands are split without a shell", "[spawn][util]") {
+  REQUIRE(splitSimpleCommand("  playerctl  status\t-p spotify ") ==
+          std::vector<std::string>{"playerctl", "status", "-p", "spotify"});
+  REQUIRE_FALSE(splitSimpleCommand(""));
+  REQUIRE_FALSE(splitSimpleCommand("echo $HOME"));
+  REQUIRE_FALSE(splitSimpleCommand("cat file | wc -l"));
+  REQUIRE_FALSE(splitSimpleCommand("echo 'a b'"));
+  REQUIRE_FALSE(splitSimpleCommand("FOO=1 env"));
+  REQUIRE_FALSE(splitSimpleCommand("ls ~"));
+  REQUIRE_FALSE(splitSimpleCommand("exit 3"));
+}
+
+TEST_CASE("Spawned commands behave as with /bin/sh -c", "[spawn][util]") {
+  SpawnOptions direct;
+  direct.direct = true;
+
+  SECTION("Direct exec is off by default") { REQUIRE_FALSE(SpawnOptions{}.direct); }
+
+  SECTION("Direct and shell commands") {
+    for (bool enabled : {false, true}) {
+      direct.direct = enabled;
+      REQUIRE(run("echo hello world", direct) ==
+              std::pair<std::string, int>{"hello world\n", 0});
+      REQUIRE(run("echo hello | tr h j", direct) == std::pair<std::string, int>{"jello\n", 0});
+      REQUIRE(run("exit 3", direct).second == 3);
+      REQUIRE(run("command-that-does-not-exist", direct).second == 127);
+    }
+  }
+
+  SECTION("Script without a shebang") {
+    char dir[] = "/tmp/waybar-spawn-XXXXXX";
+    REQUIRE(mkdtemp(dir) != nullptr);
+    auto script = std::string(dir) + "/script";
+    std::ofstream(script) << "echo from script \"$1\"\nexit 4\n";
+    REQUIRE(chmod(script.c_str(), 0700) == 0);
+    REQUIRE(run(script + " arg", direct) == std::pair<std::string, int>{"from script arg\n", 4});
+    unlink(script.c_str());
+    rmdir(dir);
+  }
+
+  SECTION("Output name") {
+    SpawnOptions options;
+    options.output_name = "DP-1";
+    REQUIRE(run("printenv WAYBAR_OUTPUT_NAME", options).first == "DP-1\n");
+  }
+
+  SECTION("Own process group") {
+    // pid and process group of the shell
+    auto [output, status] = run("echo $$ $(cut -d' ' -f5 /proc/$$/stat)");
+    auto space = output.find(' ');
+    REQUIRE(std::stoi(output.substr(0, space)) == std::stoi(output.substr(space + 1)));
+  }
+
+  SECTION("Empty signal mask") {
+    sigset_t mask;
+    sigset_t previous;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, &previous);
+    auto [output, status] = run("grep SigBlk /proc/self/status");
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    REQUIRE(output == "SigBlk:\t0000000000000000\n");
+  }
+}
+
+// Hidden, run with `utils_test "[benchmark]"`
+TEST_CASE("Spawn latency against RSS", "[.][benchmark][spawn]") {
+  static constexpr int RUNS = 200;
+  auto measure = [](auto&& start) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < RUNS; i++) {
+      pid_t pid = start();
+      REQUIRE(pid > 0);
+      waitpid(pid, nullptr, 0);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed) / RUNS;
+  };
+  auto viaFork = [] {
+    pid_t pid = fork();
+    if (pid == 0) {
+      execl("/bin/true", "true", nullptr);
+      _exit(127);
+    }
+    return pid;
+  };
+  auto viaSpawn = [] { return spawn("/bin/true"); };
+
+  std::vector<std::unique_ptr<char[]>> ballast;
+  for (size_t mib : {0, 256, 512, 1024}) {
+    while (ballast.size() < mib / 64) {
+      constexpr size_t CHUNK = 64 << 20;
+      ballast.emplace_back(new char[CHUNK]);
+      memset(ballast.back().get(), 1, CHUNK);
+    }
+    fmt::print("RSS {:>5} MiB: fork+exec {:>6}us, spawn {:>6}us\n", rssKiB() / 1024,
+               measure(viaFork).count(), measure(viaSpawn).count());
+  }
+}
@@ -0,0 +1,82 @@
+#include "util/system_sampler.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace std::chrono_literals;
+using waybar::util::SystemSampler;
+
+namespace {
+std::shared_ptr<const SystemSampler::Snapshot> waitFor(
+    const SystemSampler::Subscription& subscription,
+    const std::function<bool(const SystemSampler::Snapshot&)>& ready) {
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto snapshot = subscription.snapshot();
+    if (snapshot && ready(*snapshot)) {
+      return snapshot;
+    }
+    std::this_thread::sleep_for(5ms);
+  }
+  return nullptr;
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+  std::ofstream file(path, std::ios::trunc);
+  file << content;
+}
+}  // namespace
+
+TEST_CASE("Subscribers with the same interval share one sampling group", "[system_sampler][util]") {
+  auto& sampler = SystemSampler::inst();
+  auto before = sampler.groups();
+  {
+    auto a = sampler.subscribe(1230ms, {SystemSampler::LOADAVG}, nullptr);
+    auto b = sampler.subscribe(1230ms, {SystemSampler::MOUNTS, {}, {"/"}}, nullptr);
+    auto c = sampler.subscribe(4560ms, {SystemSampler::LOADAVG}, nullptr);
+    REQUIRE(sampler.groups() == before + 2);
+
+    auto snapshot = waitFor(b, [](const auto& s) { return s.mounts.contains("/"); });
+    REQUIRE(snapshot != nullptr);
+    REQUIRE(snapshot->loadavg.has_value());
+    REQUIRE(snapshot->mounts.at("/").stats.f_blocks > 0);
+    REQUIRE(a.snapshot() == b.snapshot());
+  }
+  REQUIRE(sampler.groups() == before);
+}
+
+TEST_CASE("Snapshots record the version in which a field changed", "[system_sampler][util]") {
+  auto path = (std::filesystem::temp_directory_path() / "waybar-test-temp_input").string();
+  writeFile(path, "42000\n");
+
+  auto subscription = SystemSampler::inst().subscribe(
+      20ms, {SystemSampler::INPUTS | SystemSampler::LOADAVG, {path}}, nullptr);
+  auto first = waitFor(subscription, [&path](const auto& s) { return s.inputs.contains(path); });
+  REQUIRE(first != nullptr);
+  REQUIRE(first->inputs.at(path).value == 42000);
+
+  // Unchanged inputs keep the version of their last change
+  auto unchanged = waitFor(subscription,
+                           [&first](const auto& s) { return s.version > first->version; });
+  REQUIRE(unchanged != nullptr);
+  REQUIRE(unchanged->inputs.at(path).changed == first->inputs.at(path).changed);
+  REQUIRE_FALSE(unchanged->changedSince(SystemSampler::INPUTS, first->version));
+
+  writeFile(path, "43500\n");
+  auto changed = waitFor(subscription,
+                         [&path](const auto& s) { return s.inputs.at(path).value == 43500; });
+  REQUIRE(changed != nullptr);
+  REQUIRE(changed->inputs.at(path).changed == changed->version);
+  REQUIRE(changed->changedSince(SystemSampler::INPUTS, unchanged->version));
+  REQUIRE_FALSE(changed->changedSince(SystemSampler::STAT, unchanged->version));
+
+  subscription.reset();
+  std::filesystem::remove(path);
+}
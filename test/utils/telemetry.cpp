@@ -0,0 +1,69 @@
+#include "util/telemetry.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+#include <thread>
+
+using namespace std::chrono_literals;
+using waybar::util::Histogram;
+using waybar::util::Telemetry;
+
+TEST_CASE("Histogram buckets durations by powers of two", "[telemetry][util]") {
+  Histogram histogram;
+  REQUIRE(histogram.count() == 0);
+  REQUIRE(histogram.percentile(0.5) == 0us);
+
+  for (int i = 0; i < 98; i++) {
+    histogram.record(3us);
+  }
+  histogram.record(100us);
+  histogram.record(10s);
+
+  REQUIRE(histogram.count() == 100);
+  REQUIRE(histogram.max() == 10s);
+  REQUIRE(histogram.sum() == 98 * 3us + 100us + 10s);
+  // 3µs lands in [2, 4)
+  REQUIRE(histogram.percentile(0.5) == 4us);
+  REQUIRE(histogram.percentile(0.99) == 128us);
+  REQUIRE(histogram.percentile(1) == 10s);
+
+  auto json = histogram.toJson();
+  REQUIRE(json["count"].asUInt64() == 100);
+  REQUIRE(json["buckets"]["4"].asUInt64() == 98);
+}
+
+TEST_CASE("Telemetry attributes work to the current module", "[telemetry][util]") {
+  auto stats = Telemetry::inst().create("custom/test", "DP-1");
+  REQUIRE(Telemetry::current() == nullptr);
+  {
+    Telemetry::Scope scope(stats);
+    REQUIRE(Telemetry::current() == stats);
+    {
+      Telemetry::Scope inner(nullptr);
+      REQUIRE(Telemetry::current() == nullptr);
+    }
+    REQUIRE(Telemetry::current() == stats);
+    // Other threads have their own current module
+    std::thread([] { REQUIRE(Telemetry::current() == nullptr); }).join();
+  }
+  REQUIRE(Telemetry::current() == nullptr);
+  stats->label_applied = 3;
+  stats->label_skipped = 5;
+
+  auto modules = Telemetry::inst().toJson()["modules"];
+  bool found = false;
+  for (const auto& module : modules) {
+    found |= module["name"].asString() == "custom/test" && module["output"].asString() == "DP-1" &&
+             module["label_applied"].asUInt64() == 3 && module["label_skipped"].asUInt64() == 5;
+  }
+  REQUIRE(found);
+  // The shared timer is reported next to the modules
+  auto scheduler = Telemetry::inst().toJson()["scheduler"];
+  REQUIRE(scheduler["wakeups"].isUInt64());
+  REQUIRE(scheduler["callbacks"].isUInt64());
+  REQUIRE(scheduler["last_tick_callbacks"].isUInt64());
+  REQUIRE(scheduler["subscriptions"].isUInt64());
+}